@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SpatialHashFileHandlePool.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/ScopeLock.h"
+
+FSpatialHashFileHandlePool& FSpatialHashFileHandlePool::Get()
+{
+	static FSpatialHashFileHandlePool Instance;
+	return Instance;
+}
+
+bool FSpatialHashFileHandlePool::ReadAt(const FString& Filename, int64 Offset, int64 NumBytes, uint8* Destination)
+{
+	if (NumBytes <= 0)
+	{
+		return true; // Nothing to read
+	}
+
+	TSharedPtr<FPooledHandle, ESPMode::ThreadSafe> Pooled = Acquire(Filename);
+	if (!Pooled.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashFileHandlePool::ReadAt: Failed to open file: %s"), *Filename);
+		return false;
+	}
+
+	// Seek and read must not interleave with another thread using the same handle
+	FScopeLock ReadLock(&Pooled->ReadMutex);
+
+	if (!Pooled->Handle->Seek(Offset))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashFileHandlePool::ReadAt: Failed to seek to offset %lld in %s"), Offset, *Filename);
+		return false;
+	}
+
+	if (!Pooled->Handle->Read(Destination, NumBytes))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashFileHandlePool::ReadAt: Failed to read %lld bytes at offset %lld from %s"),
+			NumBytes, Offset, *Filename);
+		return false;
+	}
+
+	return true;
+}
+
+TSharedPtr<FSpatialHashFileHandlePool::FPooledHandle, ESPMode::ThreadSafe> FSpatialHashFileHandlePool::Acquire(const FString& Filename)
+{
+	{
+		FScopeLock Lock(&PoolMutex);
+		if (TSharedPtr<FPooledHandle, ESPMode::ThreadSafe>* Existing = Handles.Find(Filename))
+		{
+			(*Existing)->LastUseTick = ++UseCounter;
+			return *Existing;
+		}
+	}
+
+	// Open outside the pool lock so a slow open does not block reads of other files
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	IFileHandle* RawHandle = PlatformFile.OpenRead(*Filename);
+	if (!RawHandle)
+	{
+		return nullptr;
+	}
+
+	TSharedPtr<FPooledHandle, ESPMode::ThreadSafe> NewHandle = MakeShared<FPooledHandle, ESPMode::ThreadSafe>();
+	NewHandle->Handle.Reset(RawHandle);
+
+	FScopeLock Lock(&PoolMutex);
+
+	// Another thread may have opened the same file in the meantime - prefer its handle
+	if (TSharedPtr<FPooledHandle, ESPMode::ThreadSafe>* Existing = Handles.Find(Filename))
+	{
+		(*Existing)->LastUseTick = ++UseCounter;
+		return *Existing;
+	}
+
+	NewHandle->LastUseTick = ++UseCounter;
+	Handles.Add(Filename, NewHandle);
+	EvictExcessHandles();
+
+	return NewHandle;
+}
+
+void FSpatialHashFileHandlePool::EvictExcessHandles()
+{
+	// Evicted handles stay alive until in-flight reads drop their reference
+	while (Handles.Num() > MaxOpenHandles)
+	{
+		const FString* OldestKey = nullptr;
+		uint64 OldestTick = MAX_uint64;
+
+		for (const auto& Pair : Handles)
+		{
+			if (Pair.Value->LastUseTick < OldestTick)
+			{
+				OldestTick = Pair.Value->LastUseTick;
+				OldestKey = &Pair.Key;
+			}
+		}
+
+		if (!OldestKey)
+		{
+			break;
+		}
+
+		Handles.Remove(FString(*OldestKey));
+	}
+}
+
+void FSpatialHashFileHandlePool::Release(const FString& Filename)
+{
+	FScopeLock Lock(&PoolMutex);
+	Handles.Remove(Filename);
+}
+
+void FSpatialHashFileHandlePool::ReleaseAll()
+{
+	FScopeLock Lock(&PoolMutex);
+	Handles.Reset();
+}
+
+void FSpatialHashFileHandlePool::SetMaxOpenHandles(int32 InMaxOpenHandles)
+{
+	FScopeLock Lock(&PoolMutex);
+	MaxOpenHandles = FMath::Max(1, InMaxOpenHandles);
+	EvictExcessHandles();
+}
+
+int32 FSpatialHashFileHandlePool::GetMaxOpenHandles() const
+{
+	FScopeLock Lock(&PoolMutex);
+	return MaxOpenHandles;
+}
+
+int32 FSpatialHashFileHandlePool::GetNumOpenHandles() const
+{
+	FScopeLock Lock(&PoolMutex);
+	return Handles.Num();
+}
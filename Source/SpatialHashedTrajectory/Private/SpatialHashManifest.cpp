@@ -0,0 +1,268 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "SpatialHashManifest.h"
+#include "SpatialHashTable.h"
+#include "SpatialHashTableBuilder.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Misc/Crc.h"
+#include "Algo/BinarySearch.h"
+
+FString FSpatialHashManifest::GetManifestFilename(const FString& DatasetDirectory, float CellSize)
+{
+	const FString CellSizeDirectory = FPaths::GetPath(FSpatialHashTableBuilder::GetOutputFilename(DatasetDirectory, CellSize, 0));
+	return FPaths::Combine(CellSizeDirectory, TEXT("manifest.bin"));
+}
+
+bool FSpatialHashManifest::ComputeFileChecksum(const FString& Filename, uint32& OutChecksum)
+{
+	TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!FileHandle)
+	{
+		return false;
+	}
+
+	// Chained CRC over fixed-size chunks equals the CRC of the whole file
+	constexpr int64 ChunkSize = 1024 * 1024;
+	TArray<uint8> Chunk;
+	Chunk.SetNumUninitialized(ChunkSize);
+
+	uint32 Checksum = 0;
+	int64 Remaining = FileHandle->Size();
+	while (Remaining > 0)
+	{
+		const int64 BytesToRead = FMath::Min(Remaining, ChunkSize);
+		if (!FileHandle->Read(Chunk.GetData(), BytesToRead))
+		{
+			return false;
+		}
+		Checksum = FCrc::MemCrc32(Chunk.GetData(), (int32)BytesToRead, Checksum);
+		Remaining -= BytesToRead;
+	}
+
+	OutChecksum = Checksum;
+	return true;
+}
+
+void FSpatialHashManifest::FTable::SetFromHeader(const FSpatialHashHeader& Header)
+{
+	TimeStep = (int32)Header.TimeStep;
+	NumEntries = Header.NumEntries;
+	NumTrajectoryIds = Header.NumTrajectoryIds;
+	BBoxMin = Header.GetBBoxMin();
+	BBoxMax = Header.GetBBoxMax();
+}
+
+void FSpatialHashManifest::Reset()
+{
+	Tables.Reset();
+	Shards.Reset();
+}
+
+void FSpatialHashManifest::AddTable(const FTable& Table)
+{
+	Tables.Add(Table);
+}
+
+void FSpatialHashManifest::RemoveTables(int32 StartTimeStep, int32 EndTimeStep)
+{
+	Tables.RemoveAll([StartTimeStep, EndTimeStep](const FTable& Table)
+	{
+		return Table.TimeStep >= StartTimeStep && Table.TimeStep <= EndTimeStep;
+	});
+}
+
+void FSpatialHashManifest::AddShard(const FShard& Shard)
+{
+	RemoveShard(Shard.FileName);
+	Shards.Add(Shard);
+}
+
+void FSpatialHashManifest::RemoveShard(const FString& FileName)
+{
+	Shards.RemoveAll([&FileName](const FShard& Shard)
+	{
+		return Shard.FileName == FileName;
+	});
+}
+
+const FSpatialHashManifest::FShard* FSpatialHashManifest::FindShard(const FString& FileName) const
+{
+	return Shards.FindByPredicate([&FileName](const FShard& Shard)
+	{
+		return Shard.FileName == FileName;
+	});
+}
+
+void FSpatialHashManifest::Finalize()
+{
+	// Stable, so the most recently added record of a time step ends up last in its run
+	Tables.StableSort([](const FTable& A, const FTable& B)
+	{
+		return A.TimeStep < B.TimeStep;
+	});
+
+	int32 NumKept = 0;
+	for (int32 Index = 0; Index < Tables.Num(); ++Index)
+	{
+		if (Index + 1 < Tables.Num() && Tables[Index + 1].TimeStep == Tables[Index].TimeStep)
+		{
+			continue;
+		}
+		Tables[NumKept++] = Tables[Index];
+	}
+	Tables.SetNum(NumKept);
+
+	FBox Bounds(ForceInit);
+	for (const FTable& Table : Tables)
+	{
+		Bounds += FBox(Table.BBoxMin, Table.BBoxMax);
+	}
+	BBoxMin = Bounds.IsValid ? Bounds.Min : FVector::ZeroVector;
+	BBoxMax = Bounds.IsValid ? Bounds.Max : FVector::ZeroVector;
+}
+
+const FSpatialHashManifest::FTable* FSpatialHashManifest::FindTable(int32 TimeStep) const
+{
+	const int32 Index = Algo::BinarySearchBy(Tables, TimeStep, &FTable::TimeStep);
+	return Index != INDEX_NONE ? &Tables[Index] : nullptr;
+}
+
+bool FSpatialHashManifest::HasAllTables(int32 StartTimeStep, int32 EndTimeStep) const
+{
+	// Tables are sorted and unique, so the range is complete if it spans the expected number of records
+	const int32 First = Algo::LowerBoundBy(Tables, StartTimeStep, &FTable::TimeStep);
+	const int32 Last = Algo::UpperBoundBy(Tables, EndTimeStep, &FTable::TimeStep);
+	return Last - First == EndTimeStep - StartTimeStep + 1;
+}
+
+bool FSpatialHashManifest::BuildFromTableFiles(const FString& DatasetDirectory, float InCellSize)
+{
+	Reset();
+	CellSize = InCellSize;
+
+	const FString CellSizeDirectory = FPaths::GetPath(FSpatialHashTableBuilder::GetOutputFilename(DatasetDirectory, InCellSize, 0));
+	TArray<FString> TableFiles;
+	IFileManager::Get().FindFiles(TableFiles, *FPaths::Combine(CellSizeDirectory, TEXT("timestep_*.bin")), true, false);
+
+	for (const FString& TableFile : TableFiles)
+	{
+		const FString TablePath = FPaths::Combine(CellSizeDirectory, TableFile);
+
+		FSpatialHashHeader Header;
+		FTable Table;
+		if (!FSpatialHashTable::LoadHeaderFromFile(TablePath, Header) || !ComputeFileChecksum(TablePath, Table.Checksum))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FSpatialHashManifest::BuildFromTableFiles: Skipping unreadable table %s"), *TablePath);
+			continue;
+		}
+
+		Table.SetFromHeader(Header);
+		Table.FileSize = IFileManager::Get().FileSize(*TablePath);
+		AddTable(Table);
+	}
+
+	Finalize();
+
+	UE_LOG(LogTemp, Log, TEXT("FSpatialHashManifest::BuildFromTableFiles: Recorded %d tables for cell size %.3f"),
+		Tables.Num(), CellSize);
+
+	return Tables.Num() > 0;
+}
+
+bool FSpatialHashManifest::VerifyTableFile(const FString& DatasetDirectory, int32 TimeStep) const
+{
+	const FTable* Table = FindTable(TimeStep);
+	if (!Table)
+	{
+		return false;
+	}
+
+	const FString TablePath = FSpatialHashTableBuilder::GetOutputFilename(DatasetDirectory, CellSize, TimeStep);
+	if (IFileManager::Get().FileSize(*TablePath) != Table->FileSize)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashManifest::VerifyTableFile: Size of %s does not match the manifest"), *TablePath);
+		return false;
+	}
+
+	uint32 Checksum = 0;
+	if (!ComputeFileChecksum(TablePath, Checksum) || Checksum != Table->Checksum)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashManifest::VerifyTableFile: Checksum of %s does not match the manifest"), *TablePath);
+		return false;
+	}
+
+	return true;
+}
+
+bool FSpatialHashManifest::SaveToFile(const FString& Filename) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FString Directory = FPaths::GetPath(Filename);
+	if (!Directory.IsEmpty() && !PlatformFile.DirectoryExists(*Directory))
+	{
+		PlatformFile.CreateDirectoryTree(*Directory);
+	}
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashManifest::SaveToFile: Failed to open file for writing: %s"), *Filename);
+		return false;
+	}
+
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	float FileCellSize = CellSize;
+	FVector FileBBoxMin = BBoxMin;
+	FVector FileBBoxMax = BBoxMax;
+	*Writer << FileMagic << FileVersion << FileCellSize << FileBBoxMin << FileBBoxMax;
+	*Writer << const_cast<TArray<FTable>&>(Tables);
+	*Writer << const_cast<TArray<FShard>&>(Shards);
+
+	if (!Writer->Close())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashManifest::SaveToFile: Failed to write %s"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FSpatialHashManifest::SaveToFile: Saved %d tables to %s"), Tables.Num(), *Filename);
+	return true;
+}
+
+bool FSpatialHashManifest::LoadFromFile(const FString& Filename)
+{
+	Reset();
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	*Reader << FileMagic << FileVersion;
+
+	if (FileMagic != Magic || FileVersion != Version)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashManifest::LoadFromFile: Unsupported manifest %s (magic 0x%08X, version %u)"),
+			*Filename, FileMagic, FileVersion);
+		return false;
+	}
+
+	*Reader << CellSize << BBoxMin << BBoxMax;
+	*Reader << Tables;
+	*Reader << Shards;
+
+	if (Reader->IsError())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashManifest::LoadFromFile: Failed to read %s"), *Filename);
+		Reset();
+		return false;
+	}
+
+	return true;
+}
@@ -1,9 +1,75 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SpatialHashTable.h"
+#include "SpatialHashFileHandlePool.h"
 #include "Misc/FileHelper.h"
 #include "HAL/PlatformFileManager.h"
 #include "Misc/Paths.h"
+#include "Misc/Crc.h"
+
+// Instruction set extensions used by the Z-Order conversions (compile-time selection,
+// the scalar code is the fallback). BMI2 comes with every AVX2-capable CPU; MSVC has no
+// separate BMI2 switch, so /arch:AVX2 enables it there. Whether PDEP/PEXT are actually
+// used is also decided at runtime (see HasFastPdepPext).
+#if PLATFORM_CPU_X86_FAMILY && (defined(__BMI2__) || (defined(_MSC_VER) && defined(__AVX2__)))
+	#define SPATIALHASH_USE_BMI2 1
+#else
+	#define SPATIALHASH_USE_BMI2 0
+#endif
+
+#if PLATFORM_CPU_X86_FAMILY && defined(__AVX2__)
+	#define SPATIALHASH_USE_AVX2 1
+#else
+	#define SPATIALHASH_USE_AVX2 0
+#endif
+
+#if PLATFORM_CPU_X86_FAMILY && defined(__AVX__)
+	#define SPATIALHASH_USE_AVX 1
+#else
+	#define SPATIALHASH_USE_AVX 0
+#endif
+
+#if PLATFORM_CPU_X86_FAMILY && (defined(__SSE4_1__) || (defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1))
+	#define SPATIALHASH_USE_SSE4 1
+#else
+	#define SPATIALHASH_USE_SSE4 0
+#endif
+
+#if SPATIALHASH_USE_BMI2 || SPATIALHASH_USE_AVX2 || SPATIALHASH_USE_AVX || SPATIALHASH_USE_SSE4
+	#include <immintrin.h>
+#endif
+
+// Bit positions of x, y and z in a Z-Order key
+static constexpr uint64 ZOrderMaskX = 0x1249249249249249ull;
+static constexpr uint64 ZOrderMaskY = ZOrderMaskX << 1;
+static constexpr uint64 ZOrderMaskZ = ZOrderMaskX << 2;
+
+#if SPATIALHASH_USE_BMI2
+// PDEP/PEXT are microcoded on AMD CPUs before Zen 3 (family 19h) and take hundreds of cycles
+// there, far more than the shift-and-mask code, so they are only used where they are fast
+static bool HasFastPdepPext()
+{
+	static const bool bFastPdepPext = []()
+	{
+		const FString Vendor = FPlatformMisc::GetCPUVendor();
+		if (Vendor != TEXT("AuthenticAMD") && Vendor != TEXT("HygonGenuine"))
+		{
+			return true;
+		}
+
+		const uint32 CPUInfo = FPlatformMisc::GetCPUInfo();
+		const uint32 BaseFamily = (CPUInfo >> 8) & 0xF;
+		const uint32 Family = BaseFamily == 0xF ? BaseFamily + ((CPUInfo >> 20) & 0xFF) : BaseFamily;
+		return Family >= 0x19;
+	}();
+	return bFastPdepPext;
+}
+#else
+static constexpr bool HasFastPdepPext()
+{
+	return false;
+}
+#endif
 
 // ============================================================================
 // Z-Order Curve (Morton Code) Implementation
@@ -49,9 +115,311 @@ uint64 FSpatialHashTable::CalculateZOrderKey(int32 CellX, int32 CellY, int32 Cel
 	// Interleave bits: x at bit 0, y at bit 1, z at bit 2, repeating
 	// Result pattern: ...z₂y₂x₂ z₁y₁x₁ z₀y₀x₀
 	// This creates a 63-bit Morton code (21 bits × 3 dimensions)
+#if SPATIALHASH_USE_BMI2
+	if (HasFastPdepPext())
+	{
+		return _pdep_u64(X, ZOrderMaskX) | _pdep_u64(Y, ZOrderMaskY) | _pdep_u64(Z, ZOrderMaskZ);
+	}
+#endif
 	return SplitBy3(X) | (SplitBy3(Y) << 1) | (SplitBy3(Z) << 2);
 }
 
+// Inverse of SplitBy3: gathers every 3rd bit back into a contiguous 21-bit value
+static uint32 CompactBy3(uint64 Value)
+{
+	uint64 x = Value & 0x1249249249249249;
+	x = (x | x >> 2)  & 0x10c30c30c30c30c3;
+	x = (x | x >> 4)  & 0x100f00f00f00f00f;
+	x = (x | x >> 8)  & 0x1f0000ff0000ff;
+	x = (x | x >> 16) & 0x1f00000000ffff;
+	x = (x | x >> 32) & 0x1fffff;
+	return (uint32)x;
+}
+
+void FSpatialHashTable::DecodeZOrderKey(uint64 Key, int32& OutCellX, int32& OutCellY, int32& OutCellZ)
+{
+#if SPATIALHASH_USE_BMI2
+	if (HasFastPdepPext())
+	{
+		OutCellX = (int32)_pext_u64(Key, ZOrderMaskX);
+		OutCellY = (int32)_pext_u64(Key, ZOrderMaskY);
+		OutCellZ = (int32)_pext_u64(Key, ZOrderMaskZ);
+		return;
+	}
+#endif
+	OutCellX = (int32)CompactBy3(Key);
+	OutCellY = (int32)CompactBy3(Key >> 1);
+	OutCellZ = (int32)CompactBy3(Key >> 2);
+}
+
+// ============================================================================
+// Batch Conversions
+// ============================================================================
+// The builder converts millions of samples per time step and radius queries
+// decode every candidate cell, so these loops are vectorized where the target
+// allows it:
+// - World to cell: AVX (4 lanes) or SSE4.1 (2 lanes) double division + floor,
+//   identical to the scalar FloorToInt((P - BBoxMin) / CellSize)
+// - Encoding: BMI2 PDEP (3 instructions per key) or AVX2 bit spreading (4 keys)
+// - Decoding: BMI2 PEXT or AVX2 bit compaction (4 keys)
+// PDEP/PEXT are only preferred on CPUs that execute them natively (HasFastPdepPext).
+// Remaining elements and other targets use the scalar functions.
+// ============================================================================
+
+#if SPATIALHASH_USE_AVX2
+// SplitBy3 on four 21-bit values at once (one per 64-bit lane)
+static FORCEINLINE __m256i SplitBy3x4(__m256i x)
+{
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 32)), _mm256_set1_epi64x(0x1f00000000ffff));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 16)), _mm256_set1_epi64x(0x1f0000ff0000ff));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 8)), _mm256_set1_epi64x(0x100f00f00f00f00f));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 4)), _mm256_set1_epi64x(0x10c30c30c30c30c3));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, 2)), _mm256_set1_epi64x(0x1249249249249249));
+	return x;
+}
+
+// CompactBy3 on four keys at once (one per 64-bit lane)
+static FORCEINLINE __m256i CompactBy3x4(__m256i x)
+{
+	x = _mm256_and_si256(x, _mm256_set1_epi64x(0x1249249249249249));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 2)), _mm256_set1_epi64x(0x10c30c30c30c30c3));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 4)), _mm256_set1_epi64x(0x100f00f00f00f00f));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 8)), _mm256_set1_epi64x(0x1f0000ff0000ff));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 16)), _mm256_set1_epi64x(0x1f00000000ffff));
+	x = _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, 32)), _mm256_set1_epi64x(0x1fffff));
+	return x;
+}
+
+// Store the low 32 bits of four 64-bit lanes as four consecutive int32
+static FORCEINLINE void StoreCellsx4(int32* Cells, __m256i x)
+{
+	const __m256i Packed = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(Cells), _mm256_castsi256_si128(Packed));
+}
+
+// Clamp four cell coordinates to [0, 0x1fffff] and widen them to 64-bit lanes
+static FORCEINLINE __m256i LoadClampedCellsx4(const int32* Cells)
+{
+	__m128i Values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Cells));
+	Values = _mm_min_epi32(_mm_max_epi32(Values, _mm_setzero_si128()), _mm_set1_epi32(0x1fffff));
+	return _mm256_cvtepu32_epi64(Values);
+}
+#endif
+
+void FSpatialHashTable::WorldToCellCoordinatesBatch(
+	TArrayView<const FVector::FReal> PosX,
+	TArrayView<const FVector::FReal> PosY,
+	TArrayView<const FVector::FReal> PosZ,
+	const FVector& BBoxMin,
+	float CellSize,
+	TArrayView<int32> OutCellX,
+	TArrayView<int32> OutCellY,
+	TArrayView<int32> OutCellZ)
+{
+	const int32 Num = PosX.Num();
+	check(PosY.Num() == Num && PosZ.Num() == Num);
+	check(OutCellX.Num() >= Num && OutCellY.Num() >= Num && OutCellZ.Num() >= Num);
+
+	if (CellSize <= SMALL_NUMBER)
+	{
+		FMemory::Memzero(OutCellX.GetData(), Num * sizeof(int32));
+		FMemory::Memzero(OutCellY.GetData(), Num * sizeof(int32));
+		FMemory::Memzero(OutCellZ.GetData(), Num * sizeof(int32));
+		return;
+	}
+
+	int32 i = 0;
+
+#if SPATIALHASH_USE_AVX || SPATIALHASH_USE_SSE4
+	if constexpr (sizeof(FVector::FReal) == sizeof(double))
+	{
+		const double* X = reinterpret_cast<const double*>(PosX.GetData());
+		const double* Y = reinterpret_cast<const double*>(PosY.GetData());
+		const double* Z = reinterpret_cast<const double*>(PosZ.GetData());
+
+#if SPATIALHASH_USE_AVX
+		const __m256d MinX = _mm256_set1_pd(BBoxMin.X);
+		const __m256d MinY = _mm256_set1_pd(BBoxMin.Y);
+		const __m256d MinZ = _mm256_set1_pd(BBoxMin.Z);
+		const __m256d Size = _mm256_set1_pd(CellSize);
+
+		for (; i + 4 <= Num; i += 4)
+		{
+			const __m256d CellX = _mm256_floor_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(X + i), MinX), Size));
+			const __m256d CellY = _mm256_floor_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(Y + i), MinY), Size));
+			const __m256d CellZ = _mm256_floor_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(Z + i), MinZ), Size));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutCellX.GetData() + i), _mm256_cvtpd_epi32(CellX));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutCellY.GetData() + i), _mm256_cvtpd_epi32(CellY));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutCellZ.GetData() + i), _mm256_cvtpd_epi32(CellZ));
+		}
+#else
+		const __m128d MinX = _mm_set1_pd(BBoxMin.X);
+		const __m128d MinY = _mm_set1_pd(BBoxMin.Y);
+		const __m128d MinZ = _mm_set1_pd(BBoxMin.Z);
+		const __m128d Size = _mm_set1_pd(CellSize);
+
+		for (; i + 2 <= Num; i += 2)
+		{
+			const __m128d CellX = _mm_floor_pd(_mm_div_pd(_mm_sub_pd(_mm_loadu_pd(X + i), MinX), Size));
+			const __m128d CellY = _mm_floor_pd(_mm_div_pd(_mm_sub_pd(_mm_loadu_pd(Y + i), MinY), Size));
+			const __m128d CellZ = _mm_floor_pd(_mm_div_pd(_mm_sub_pd(_mm_loadu_pd(Z + i), MinZ), Size));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(OutCellX.GetData() + i), _mm_cvtpd_epi32(CellX));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(OutCellY.GetData() + i), _mm_cvtpd_epi32(CellY));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(OutCellZ.GetData() + i), _mm_cvtpd_epi32(CellZ));
+		}
+#endif
+	}
+#endif
+
+	for (; i < Num; ++i)
+	{
+		WorldToCellCoordinates(FVector(PosX[i], PosY[i], PosZ[i]), BBoxMin, CellSize, OutCellX[i], OutCellY[i], OutCellZ[i]);
+	}
+}
+
+void FSpatialHashTable::CalculateZOrderKeysBatch(
+	TArrayView<const int32> CellX,
+	TArrayView<const int32> CellY,
+	TArrayView<const int32> CellZ,
+	TArrayView<uint64> OutKeys)
+{
+	const int32 Num = CellX.Num();
+	check(CellY.Num() == Num && CellZ.Num() == Num);
+	check(OutKeys.Num() >= Num);
+
+	int32 i = 0;
+
+#if SPATIALHASH_USE_AVX2
+	// With fast PDEP the scalar path is already the fastest option
+	if (!HasFastPdepPext())
+	{
+		for (; i + 4 <= Num; i += 4)
+		{
+			const __m256i X = SplitBy3x4(LoadClampedCellsx4(CellX.GetData() + i));
+			const __m256i Y = SplitBy3x4(LoadClampedCellsx4(CellY.GetData() + i));
+			const __m256i Z = SplitBy3x4(LoadClampedCellsx4(CellZ.GetData() + i));
+			const __m256i Keys = _mm256_or_si256(X, _mm256_or_si256(_mm256_slli_epi64(Y, 1), _mm256_slli_epi64(Z, 2)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(OutKeys.GetData() + i), Keys);
+		}
+	}
+#endif
+
+	for (; i < Num; ++i)
+	{
+		OutKeys[i] = CalculateZOrderKey(CellX[i], CellY[i], CellZ[i]);
+	}
+}
+
+void FSpatialHashTable::DecodeZOrderKeysBatch(
+	TArrayView<const uint64> Keys,
+	TArrayView<int32> OutCellX,
+	TArrayView<int32> OutCellY,
+	TArrayView<int32> OutCellZ)
+{
+	const int32 Num = Keys.Num();
+	check(OutCellX.Num() >= Num && OutCellY.Num() >= Num && OutCellZ.Num() >= Num);
+
+	int32 i = 0;
+
+#if SPATIALHASH_USE_AVX2
+	// With fast PEXT the scalar path is already the fastest option
+	if (!HasFastPdepPext())
+	{
+		for (; i + 4 <= Num; i += 4)
+		{
+			const __m256i Key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Keys.GetData() + i));
+			StoreCellsx4(OutCellX.GetData() + i, CompactBy3x4(Key));
+			StoreCellsx4(OutCellY.GetData() + i, CompactBy3x4(_mm256_srli_epi64(Key, 1)));
+			StoreCellsx4(OutCellZ.GetData() + i, CompactBy3x4(_mm256_srli_epi64(Key, 2)));
+		}
+	}
+#endif
+
+	for (; i < Num; ++i)
+	{
+		DecodeZOrderKey(Keys[i], OutCellX[i], OutCellY[i], OutCellZ[i]);
+	}
+}
+
+// ============================================================================
+// Z-Order Range Search (BIGMIN)
+// ============================================================================
+// An axis-aligned box of cells maps to the Morton interval [MinKey, MaxKey]
+// (the keys of its min and max corner), but that interval also contains many
+// keys outside the box. BIGMIN (Tropf & Herzog, 1981) computes the smallest
+// key greater than a given out-of-box key that lies inside the box again, so a
+// scan over the sorted entries can jump over every run of keys outside the box.
+//
+// The scan only moves forward, so the mirrored LITMAX operation (largest
+// in-box key below a given key) is not needed here.
+// ============================================================================
+
+// Bits belonging to each dimension in a Morton key (x at bit 0, y at bit 1, z at bit 2)
+static constexpr uint64 MortonDimensionMasks[3] =
+{
+	0x1249249249249249ull,
+	0x2492492492492492ull,
+	0x4924924924924924ull
+};
+
+static bool IsZOrderKeyInBox(uint64 Key, uint64 MinKey, uint64 MaxKey)
+{
+	// Dilated integers keep their order, so each dimension can be compared in place
+	for (int32 Dim = 0; Dim < 3; ++Dim)
+	{
+		const uint64 Mask = MortonDimensionMasks[Dim];
+		const uint64 KeyBits = Key & Mask;
+		if (KeyBits < (MinKey & Mask) || KeyBits > (MaxKey & Mask))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+uint64 FSpatialHashTable::ComputeBigMin(uint64 Key, uint64 MinKey, uint64 MaxKey)
+{
+	uint64 BigMin = 0;
+
+	for (int32 Bit = 62; Bit >= 0; --Bit)
+	{
+		const uint64 BitMask = 1ull << Bit;
+		const uint64 DimMask = MortonDimensionMasks[Bit % 3];
+		// Bits of this dimension at and below the current bit
+		const uint64 DimLowMask = DimMask & ((BitMask << 1) - 1);
+
+		const uint32 KeyBit = (Key & BitMask) ? 1 : 0;
+		const uint32 MinBit = (MinKey & BitMask) ? 1 : 0;
+		const uint32 MaxBit = (MaxKey & BitMask) ? 1 : 0;
+
+		switch ((KeyBit << 2) | (MinBit << 1) | MaxBit)
+		{
+		case 0b001:
+			// Box straddles this bit: the upper half starts at "1000..." in this dimension,
+			// the search continues in the lower half ending at "0111..."
+			BigMin = (MinKey & ~DimLowMask) | BitMask;
+			MaxKey = (MaxKey & ~DimLowMask) | (DimMask & (BitMask - 1));
+			break;
+		case 0b011:
+			// Key is below the box in this dimension
+			return MinKey;
+		case 0b100:
+			// Key is above the box in this dimension
+			return BigMin;
+		case 0b101:
+			// Key is in the upper half - shrink the box to it
+			MinKey = (MinKey & ~DimLowMask) | BitMask;
+			break;
+		default:
+			// 000 and 111: all three agree, continue with the next bit
+			// 010 and 110 cannot happen for a valid box (MinKey <= MaxKey per dimension)
+			break;
+		}
+	}
+
+	return BigMin;
+}
+
 void FSpatialHashTable::WorldToCellCoordinates(
 	const FVector& WorldPos,
 	const FVector& BBoxMin,
@@ -74,21 +442,75 @@ void FSpatialHashTable::WorldToCellCoordinates(
 	}
 }
 
+// Home slot of a key in a hash index of 2^(64 - Shift) slots (Fibonacci hashing - Morton keys of
+// neighbouring cells differ mostly in their low bits, the multiply spreads them over the top bits)
+static FORCEINLINE uint32 GetHashIndexHomeSlot(uint64 Key, uint32 Shift)
+{
+	return (uint32)((Key * 0x9E3779B97F4A7C15ull) >> Shift);
+}
+
 int32 FSpatialHashTable::FindEntry(uint64 Key) const
 {
-	// Binary search in sorted entries array
+	// Slots exist only while the hash index is enabled
+	if (HashIndexSlots.Num() > 0)
+	{
+		TArrayView<const FHashIndexSlot> Slots = HashIndexSlots;
+		const uint32 Mask = (uint32)Slots.Num() - 1;
+
+		// Robin Hood order: once the probe is farther from home than the slot's key, the key is absent
+		uint32 Slot = GetHashIndexHomeSlot(Key, HashIndexShift);
+		for (uint32 Distance = 0; ; ++Distance, Slot = (Slot + 1) & Mask)
+		{
+			const FHashIndexSlot& Current = Slots[Slot];
+			if (Current.EntryIndex == INDEX_NONE || Current.ProbeDistance < Distance)
+			{
+				return -1;
+			}
+			if (Current.Key == Key)
+			{
+				return Current.EntryIndex;
+			}
+		}
+	}
+
+	if (HasSearchIndex())
+	{
+		// Descend the implicit tree: node K has children 2K and 2K+1. The 16 nodes four levels
+		// below K are contiguous and start on a cache line, so prefetching them hides the misses.
+		const int64 NumKeys = SearchKeys.Num() - 1;
+		const uint64* Keys = SearchKeys.GetData();
+		int64 Node = 1;
+		while (Node <= NumKeys)
+		{
+			FPlatformMisc::Prefetch(Keys + 16 * Node);
+			FPlatformMisc::Prefetch(Keys + 16 * Node, 64);
+			Node = 2 * Node + (Keys[Node] < Key);
+		}
+
+		// Undo the right turns taken after the last left turn: that node is the lower bound
+		Node >>= FMath::CountTrailingZeros64(~(uint64)Node) + 1;
+		return Node != 0 && Keys[Node] == Key ? SearchEntryIndices[Node] : -1;
+	}
+
+	if (HasLearnedIndex())
+	{
+		return FindEntryLearned(Key);
+	}
+
+	// Binary search in the dense sorted key array
+	TArrayView<const uint64> SortedKeys = GetEntryKeys();
 	int32 Left = 0;
-	int32 Right = Entries.Num() - 1;
+	int32 Right = SortedKeys.Num() - 1;
 	
 	while (Left <= Right)
 	{
 		int32 Mid = Left + (Right - Left) / 2;
 		
-		if (Entries[Mid].ZOrderKey == Key)
+		if (SortedKeys[Mid] == Key)
 		{
 			return Mid;
 		}
-		else if (Entries[Mid].ZOrderKey < Key)
+		else if (SortedKeys[Mid] < Key)
 		{
 			Left = Mid + 1;
 		}
@@ -97,133 +519,1253 @@ int32 FSpatialHashTable::FindEntry(uint64 Key) const
 			Right = Mid - 1;
 		}
 	}
-	
-	return -1; // Not found
+	
+	return -1; // Not found
+}
+
+// Fill the Eytzinger layout by an in-order walk of the implicit tree
+static void FillSearchIndex(TArrayView<const uint64> SortedKeys, int64 Node, int32& NextEntry, uint64* OutKeys, int32* OutEntryIndices)
+{
+	if (Node < SortedKeys.Num() + 1)
+	{
+		FillSearchIndex(SortedKeys, 2 * Node, NextEntry, OutKeys, OutEntryIndices);
+		OutKeys[Node] = SortedKeys[NextEntry];
+		OutEntryIndices[Node] = NextEntry++;
+		FillSearchIndex(SortedKeys, 2 * Node + 1, NextEntry, OutKeys, OutEntryIndices);
+	}
+}
+
+void FSpatialHashTable::BuildSearchIndex()
+{
+	SearchKeys.Empty();
+	SearchEntryIndices.Empty();
+
+	TArrayView<const uint64> SortedKeys = GetEntryKeys();
+	if (SortedKeys.Num() == 0)
+	{
+		return;
+	}
+
+	SearchKeys.SetNumZeroed(SortedKeys.Num() + 1);
+	SearchEntryIndices.SetNumZeroed(SortedKeys.Num() + 1);
+
+	int32 NextEntry = 0;
+	FillSearchIndex(SortedKeys, 1, NextEntry, SearchKeys.GetData(), SearchEntryIndices.GetData());
+}
+
+void FSpatialHashTable::ResetSearchIndex()
+{
+	SearchKeys.Empty();
+	SearchEntryIndices.Empty();
+}
+
+void FSpatialHashTable::SetUseHashIndex(bool bEnable)
+{
+	if (bEnable == bUseHashIndex)
+	{
+		return;
+	}
+
+	bUseHashIndex = bEnable;
+	if (bEnable)
+	{
+		BuildHashIndex();
+	}
+	else
+	{
+		ResetHashIndex();
+	}
+}
+
+void FSpatialHashTable::ResetHashIndex()
+{
+	HashIndexSlots.Empty();
+	HashIndexShift = 64;
+}
+
+void FSpatialHashTable::BuildHashIndex()
+{
+	TArrayView<const uint64> Keys = GetEntryKeys();
+
+	// At most 2/3 full, so probe sequences stay short and every lookup reaches an empty slot
+	const uint64 NumSlots = FMath::RoundUpToPowerOfTwo64(FMath::Max<uint64>((uint64)Keys.Num() * 3 / 2 + 1, 16));
+	const uint32 Mask = (uint32)NumSlots - 1;
+	HashIndexShift = 64 - FMath::FloorLog2_64(NumSlots);
+
+	FHashIndexSlot EmptySlot;
+	EmptySlot.Key = 0;
+	EmptySlot.EntryIndex = INDEX_NONE;
+	EmptySlot.ProbeDistance = 0;
+	HashIndexSlots.Init(EmptySlot, (int32)NumSlots);
+
+	for (int32 EntryIndex = 0; EntryIndex < Keys.Num(); ++EntryIndex)
+	{
+		FHashIndexSlot Insert;
+		Insert.Key = Keys[EntryIndex];
+		Insert.EntryIndex = EntryIndex;
+		Insert.ProbeDistance = 0;
+
+		// Robin Hood: take the slot of any key that is closer to its home, then keep inserting that one
+		uint32 Slot = GetHashIndexHomeSlot(Insert.Key, HashIndexShift);
+		for (;; Slot = (Slot + 1) & Mask, ++Insert.ProbeDistance)
+		{
+			FHashIndexSlot& Current = HashIndexSlots[Slot];
+			if (Current.EntryIndex == INDEX_NONE)
+			{
+				Current = Insert;
+				break;
+			}
+			if (Current.ProbeDistance < Insert.ProbeDistance)
+			{
+				Swap(Current, Insert);
+			}
+		}
+	}
+}
+
+// Index of the first entry in [First, Num) whose key is not less than Key
+static int32 LowerBoundEntry(TArrayView<const uint64> SortedKeys, uint64 Key, int32 First);
+
+// ============================================================================
+// Learned Entry Index
+// ============================================================================
+// Entry index as a function of the key is monotone and, for the keys of one time
+// step, close to piecewise linear. The learned index stores linear segments that
+// predict every key's entry index within LearnedMaxError entries (PGM / RadixSpline
+// style), so FindEntry:
+//   1. buckets the key by its top bits to find the few candidate segments,
+//   2. picks the last segment starting at or before the key,
+//   3. binary searches only the window of 2 * LearnedMaxError + 1 entries around
+//      the segment's prediction.
+// ============================================================================
+
+// Entry index predicted by a segment for a key at or after its first key
+static FORCEINLINE int64 PredictLearnedEntry(const FSpatialHashLearnedSegment& Segment, uint64 Key)
+{
+	return (int64)Segment.FirstIndex + (int64)((double)Segment.Slope * (double)(Key - Segment.FirstKey));
+}
+
+void FSpatialHashTable::BuildLearnedIndex(uint32 MaxError)
+{
+	ResetLearnedIndex();
+
+	TArrayView<const uint64> Keys = GetEntryKeys();
+	if (Keys.Num() == 0)
+	{
+		return;
+	}
+
+	// Shrinking cone: extend a segment while some slope through its first key keeps
+	// every key so far within MaxError of its index
+	const double Error = (double)FMath::Max(MaxError, 1u);
+	int32 SegmentStart = 0;
+	while (SegmentStart < Keys.Num())
+	{
+		double MinSlope = 0.0;
+		double MaxSlope = TNumericLimits<double>::Max();
+		int32 SegmentEnd = SegmentStart + 1;
+		for (; SegmentEnd < Keys.Num(); ++SegmentEnd)
+		{
+			const double KeyDelta = (double)(Keys[SegmentEnd] - Keys[SegmentStart]);
+			const double IndexDelta = (double)(SegmentEnd - SegmentStart);
+			const double NewMinSlope = FMath::Max(MinSlope, (IndexDelta - Error) / KeyDelta);
+			const double NewMaxSlope = FMath::Min(MaxSlope, (IndexDelta + Error) / KeyDelta);
+			if (NewMinSlope > NewMaxSlope)
+			{
+				break;
+			}
+			MinSlope = NewMinSlope;
+			MaxSlope = NewMaxSlope;
+		}
+
+		FSpatialHashLearnedSegment& Segment = LearnedSegments.AddDefaulted_GetRef();
+		Segment.FirstKey = Keys[SegmentStart];
+		Segment.Slope = SegmentEnd - SegmentStart > 1 ? (float)((MinSlope + MaxSlope) * 0.5) : 0.0f;
+		Segment.FirstIndex = (uint32)SegmentStart;
+
+		SegmentStart = SegmentEnd;
+	}
+
+	// Measure the error as FindEntry computes it (float slope, truncated prediction)
+	LearnedMaxError = 0;
+	for (int32 SegmentIndex = 0; SegmentIndex < LearnedSegments.Num(); ++SegmentIndex)
+	{
+		const FSpatialHashLearnedSegment& Segment = LearnedSegments[SegmentIndex];
+		const int32 SegmentEnd = SegmentIndex + 1 < LearnedSegments.Num() ? (int32)LearnedSegments[SegmentIndex + 1].FirstIndex : Keys.Num();
+		for (int32 EntryIndex = (int32)Segment.FirstIndex; EntryIndex < SegmentEnd; ++EntryIndex)
+		{
+			const int64 Distance = FMath::Abs(PredictLearnedEntry(Segment, Keys[EntryIndex]) - EntryIndex);
+			LearnedMaxError = FMath::Max(LearnedMaxError, (uint32)Distance);
+		}
+	}
+
+	BuildLearnedRadixTable();
+}
+
+void FSpatialHashTable::ResetLearnedIndex()
+{
+	LearnedSegments.Empty();
+	LearnedRadixTable.Empty();
+	LearnedMaxError = 0;
+	LearnedRadixShift = 0;
+}
+
+void FSpatialHashTable::BuildLearnedRadixTable()
+{
+	TArrayView<const uint64> Keys = GetEntryKeys();
+	const int32 NumSegments = LearnedSegments.Num();
+
+	// About two buckets per segment, so most buckets hold at most one segment start
+	const uint32 RadixBits = (uint32)FMath::Clamp((int32)FMath::FloorLog2((uint32)NumSegments) + 2, 1, 20);
+	const uint64 KeyRange = Keys.Last() - Keys[0];
+	const uint32 KeyBits = KeyRange > 0 ? FMath::FloorLog2_64(KeyRange) + 1 : 0;
+	LearnedRadixShift = KeyBits > RadixBits ? KeyBits - RadixBits : 0;
+
+	const int32 NumBuckets = (int32)(KeyRange >> LearnedRadixShift) + 1;
+	LearnedRadixTable.SetNumUninitialized(NumBuckets + 1);
+
+	int32 SegmentIndex = 0;
+	for (int32 Bucket = 0; Bucket <= NumBuckets; ++Bucket)
+	{
+		while (SegmentIndex < NumSegments && ((LearnedSegments[SegmentIndex].FirstKey - Keys[0]) >> LearnedRadixShift) < (uint64)Bucket)
+		{
+			++SegmentIndex;
+		}
+		LearnedRadixTable[Bucket] = (uint32)SegmentIndex;
+	}
+}
+
+int32 FSpatialHashTable::FindEntryLearned(uint64 Key) const
+{
+	TArrayView<const uint64> Keys = GetEntryKeys();
+	if (Key < Keys[0] || Key > Keys.Last())
+	{
+		return -1;
+	}
+
+	// Segments starting in the key's bucket, plus the last one of the buckets before it
+	const uint64 Bucket = (Key - Keys[0]) >> LearnedRadixShift;
+	int32 First = (int32)LearnedRadixTable[Bucket];
+	int32 Last = (int32)LearnedRadixTable[Bucket + 1];
+	if (First > 0)
+	{
+		--First;
+	}
+
+	// Last segment starting at or before the key (the first candidate always does)
+	while (First + 1 < Last)
+	{
+		const int32 Mid = First + (Last - First) / 2;
+		if (LearnedSegments[Mid].FirstKey <= Key)
+		{
+			First = Mid;
+		}
+		else
+		{
+			Last = Mid;
+		}
+	}
+
+	// Search only the window the model's error allows
+	const int64 Predicted = FMath::Clamp<int64>(PredictLearnedEntry(LearnedSegments[First], Key), 0, Keys.Num() - 1);
+	const int32 WindowFirst = (int32)FMath::Max<int64>(Predicted - LearnedMaxError, 0);
+	const int32 WindowEnd = (int32)FMath::Min<int64>(Predicted + LearnedMaxError + 1, Keys.Num());
+	const int32 Index = LowerBoundEntry(Keys.Slice(0, WindowEnd), Key, WindowFirst);
+
+	return Index < WindowEnd && Keys[Index] == Key ? Index : -1;
+}
+
+void FSpatialHashTable::WriteLearnedIndex(TArray<uint8>& OutBytes) const
+{
+	const uint32 NumSegments = (uint32)LearnedSegments.Num();
+
+	OutBytes.Reset();
+	OutBytes.Append(reinterpret_cast<const uint8*>(&LearnedMaxError), sizeof(uint32));
+	OutBytes.Append(reinterpret_cast<const uint8*>(&NumSegments), sizeof(uint32));
+	OutBytes.Append(reinterpret_cast<const uint8*>(LearnedSegments.GetData()), LearnedSegments.NumBytes());
+}
+
+bool FSpatialHashTable::ReadLearnedIndex(const uint8* Bytes, int64 NumBytes)
+{
+	ResetLearnedIndex();
+
+	TArrayView<const uint64> Keys = GetEntryKeys();
+	uint32 MaxError = 0;
+	uint32 NumSegments = 0;
+	if (NumBytes < 2 * (int64)sizeof(uint32))
+	{
+		return false;
+	}
+	FMemory::Memcpy(&MaxError, Bytes, sizeof(uint32));
+	FMemory::Memcpy(&NumSegments, Bytes + sizeof(uint32), sizeof(uint32));
+	if (NumSegments == 0 || Keys.Num() == 0 || NumBytes != 2 * (int64)sizeof(uint32) + (int64)NumSegments * sizeof(FSpatialHashLearnedSegment))
+	{
+		return false;
+	}
+
+	// Trailer follows variable-size sections, so it is copied rather than viewed in place
+	LearnedSegments.SetNumUninitialized(NumSegments);
+	FMemory::Memcpy(LearnedSegments.GetData(), Bytes + 2 * sizeof(uint32), LearnedSegments.NumBytes());
+
+	// Segments must start at distinct entries, in order, beginning with the first
+	for (int32 SegmentIndex = 0; SegmentIndex < LearnedSegments.Num(); ++SegmentIndex)
+	{
+		const FSpatialHashLearnedSegment& Segment = LearnedSegments[SegmentIndex];
+		const bool bValidStart = SegmentIndex == 0
+			? Segment.FirstIndex == 0
+			: Segment.FirstIndex > LearnedSegments[SegmentIndex - 1].FirstIndex;
+		if (!bValidStart || Segment.FirstIndex >= (uint32)Keys.Num() || Segment.FirstKey != Keys[Segment.FirstIndex] || !FMath::IsFinite(Segment.Slope))
+		{
+			ResetLearnedIndex();
+			return false;
+		}
+	}
+
+	LearnedMaxError = MaxError;
+	BuildLearnedRadixTable();
+	return true;
+}
+
+// Index of the first entry in [First, Num) whose key is not less than Key
+static int32 LowerBoundEntry(TArrayView<const uint64> SortedKeys, uint64 Key, int32 First)
+{
+	int32 Left = First;
+	int32 Right = SortedKeys.Num();
+
+	while (Left < Right)
+	{
+		int32 Mid = Left + (Right - Left) / 2;
+
+		if (SortedKeys[Mid] < Key)
+		{
+			Left = Mid + 1;
+		}
+		else
+		{
+			Right = Mid;
+		}
+	}
+
+	return Left;
+}
+
+int32 FSpatialHashTable::FindEntriesInCellBox(const FIntVector& MinCell, const FIntVector& MaxCell, TArray<int32>& OutEntryIndices) const
+{
+	OutEntryIndices.Reset();
+
+	// Reject boxes that are empty or lie entirely outside the representable coordinate range
+	for (int32 Axis = 0; Axis < 3; ++Axis)
+	{
+		if (MinCell[Axis] > MaxCell[Axis] || MaxCell[Axis] < 0 || MinCell[Axis] > 0x1fffff)
+		{
+			return 0;
+		}
+	}
+
+	// Clamp to the coordinate range representable by the Z-Order key
+	const FIntVector ClampedMin(
+		FMath::Clamp(MinCell.X, 0, 0x1fffff),
+		FMath::Clamp(MinCell.Y, 0, 0x1fffff),
+		FMath::Clamp(MinCell.Z, 0, 0x1fffff));
+	const FIntVector ClampedMax(
+		FMath::Clamp(MaxCell.X, 0, 0x1fffff),
+		FMath::Clamp(MaxCell.Y, 0, 0x1fffff),
+		FMath::Clamp(MaxCell.Z, 0, 0x1fffff));
+
+	const uint64 MinKey = CalculateZOrderKey(ClampedMin.X, ClampedMin.Y, ClampedMin.Z);
+	const uint64 MaxKey = CalculateZOrderKey(ClampedMax.X, ClampedMax.Y, ClampedMax.Z);
+
+	TArrayView<const uint64> SortedKeys = GetEntryKeys();
+	int32 Index = LowerBoundEntry(SortedKeys, MinKey, 0);
+
+	while (Index < SortedKeys.Num())
+	{
+		const uint64 Key = SortedKeys[Index];
+		if (Key > MaxKey)
+		{
+			break;
+		}
+
+		if (IsZOrderKeyInBox(Key, MinKey, MaxKey))
+		{
+			// Inside the current key interval - keep scanning linearly
+			OutEntryIndices.Add(Index);
+			++Index;
+		}
+		else
+		{
+			// Left the box - jump to the start of the next interval
+			Index = LowerBoundEntry(SortedKeys, ComputeBigMin(Key, MinKey, MaxKey), Index + 1);
+		}
+	}
+
+	return OutEntryIndices.Num();
+}
+
+// ============================================================================
+// Trajectory ID Block Compression (format version 2 and later)
+// ============================================================================
+// Each cell's trajectory IDs are sorted and delta encoded (the first ID is
+// stored as is), then written in the StreamVByte layout (Lemire et al.):
+//   [ceil(N/4) control bytes][data bytes]
+// Every control byte holds the 2-bit codes (byte length - 1) of four
+// consecutive deltas, low bits first. The data bytes are the deltas in little
+// endian with leading zero bytes dropped. Trajectories sharing a cell tend to
+// have nearby IDs, so most deltas take one or two bytes instead of four.
+//
+// Keeping control and data bytes apart lets the decoder expand four deltas at
+// once with a single PSHUFB driven by a 256-entry shuffle table, followed by
+// an SSE prefix sum that turns the deltas back into IDs.
+//
+// A block's size follows from its control bytes, so only the offset of every
+// EntryGroupSize-th block is stored; the others are found by skipping the
+// preceding blocks of their group.
+// ============================================================================
+
+struct FIdBlockTables
+{
+	/** Number of data bytes described by each control byte */
+	uint8 DataLength[256];
+
+	/** PSHUFB masks expanding the data bytes of each control byte into four uint32 lanes */
+	uint8 Shuffle[256][16];
+
+	FIdBlockTables()
+	{
+		for (int32 Control = 0; Control < 256; ++Control)
+		{
+			int32 Offset = 0;
+			for (int32 Lane = 0; Lane < 4; ++Lane)
+			{
+				const int32 Length = ((Control >> (2 * Lane)) & 3) + 1;
+				for (int32 Byte = 0; Byte < 4; ++Byte)
+				{
+					// 0x80 makes PSHUFB write a zero byte
+					Shuffle[Control][Lane * 4 + Byte] = Byte < Length ? (uint8)(Offset + Byte) : 0x80;
+				}
+				Offset += Length;
+			}
+			DataLength[Control] = (uint8)Offset;
+		}
+	}
+};
+
+static const FIdBlockTables& GetIdBlockTables()
+{
+	static const FIdBlockTables Tables;
+	return Tables;
+}
+
+// Byte length of the I-th delta of a block
+static FORCEINLINE uint32 GetIdDeltaLength(const uint8* Control, uint32 I)
+{
+	return ((Control[I / 4] >> (2 * (I % 4))) & 3) + 1;
+}
+
+// Append the block of one cell; the IDs must be sorted ascending
+static void EncodeIdBlock(TArrayView<const uint32> SortedIds, TArray64<uint8>& OutBlocks)
+{
+	const int64 ControlStart = OutBlocks.Num();
+	OutBlocks.AddZeroed((SortedIds.Num() + 3) / 4);
+
+	uint32 Previous = 0;
+	for (int32 i = 0; i < SortedIds.Num(); ++i)
+	{
+		const uint32 Delta = SortedIds[i] - Previous;
+		Previous = SortedIds[i];
+
+		const uint32 Length = Delta < (1u << 8) ? 1 : Delta < (1u << 16) ? 2 : Delta < (1u << 24) ? 3 : 4;
+		OutBlocks[ControlStart + i / 4] |= (uint8)((Length - 1) << (2 * (i % 4)));
+		for (uint32 Byte = 0; Byte < Length; ++Byte)
+		{
+			OutBlocks.Add((uint8)(Delta >> (8 * Byte)));
+		}
+	}
+}
+
+// Size in bytes of the block of Count IDs starting at Block, or -1 if it does not fit in AvailableBytes
+static int64 GetIdBlockSize(const uint8* Block, int64 AvailableBytes, uint32 Count)
+{
+	const int64 NumControlBytes = ((int64)Count + 3) / 4;
+	if (AvailableBytes < NumControlBytes)
+	{
+		return -1;
+	}
+
+	const FIdBlockTables& Tables = GetIdBlockTables();
+	int64 NumDataBytes = 0;
+	for (uint32 Group = 0; Group < Count / 4; ++Group)
+	{
+		NumDataBytes += Tables.DataLength[Block[Group]];
+	}
+	for (uint32 i = Count & ~3u; i < Count; ++i)
+	{
+		NumDataBytes += GetIdDeltaLength(Block, i);
+	}
+
+	return NumControlBytes + NumDataBytes <= AvailableBytes ? NumControlBytes + NumDataBytes : -1;
+}
+
+// Decode the block of one cell into Count IDs.
+// AvailableBytes may extend past the block: the SSE path loads 16 data bytes at a time
+// and falls back to the scalar loop near the end of the available bytes.
+// Returns false if the block is truncated.
+static bool DecodeIdBlock(const uint8* Block, int64 AvailableBytes, uint32 Count, uint32* OutIds)
+{
+	// Check the block size up front so the loops below need no bounds checks
+	if (GetIdBlockSize(Block, AvailableBytes, Count) < 0)
+	{
+		return false;
+	}
+
+	const FIdBlockTables& Tables = GetIdBlockTables();
+	const uint8* Control = Block;
+	const uint8* Data = Block + ((int64)Count + 3) / 4;
+	const uint8* End = Block + AvailableBytes;
+	uint32 Previous = 0;
+	uint32 i = 0;
+
+#if SPATIALHASH_USE_SSE4
+	__m128i PreviousIds = _mm_setzero_si128();
+	for (; i + 4 <= Count && Data + 16 <= End; i += 4)
+	{
+		const uint8 Code = Control[i / 4];
+		const __m128i Deltas = _mm_shuffle_epi8(
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(Data)),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(Tables.Shuffle[Code])));
+
+		// Inclusive prefix sum over the four lanes, offset by the last ID of the previous group
+		__m128i Ids = _mm_add_epi32(Deltas, _mm_slli_si128(Deltas, 4));
+		Ids = _mm_add_epi32(Ids, _mm_slli_si128(Ids, 8));
+		Ids = _mm_add_epi32(Ids, PreviousIds);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(OutIds + i), Ids);
+
+		PreviousIds = _mm_shuffle_epi32(Ids, _MM_SHUFFLE(3, 3, 3, 3));
+		Data += Tables.DataLength[Code];
+	}
+	Previous = (uint32)_mm_cvtsi128_si32(PreviousIds);
+#endif
+
+	for (; i < Count; ++i)
+	{
+		const uint32 Length = GetIdDeltaLength(Control, i);
+		uint32 Delta = 0;
+		for (uint32 Byte = 0; Byte < Length; ++Byte)
+		{
+			Delta |= (uint32)Data[Byte] << (8 * Byte);
+		}
+		Data += Length;
+		Previous += Delta;
+		OutIds[i] = Previous;
+	}
+
+	return true;
+}
+
+// FCrc::MemCrc32 takes a 32-bit length, so large sections are fed in chunks
+static uint32 MemCrc32Chunked(const uint8* Data, int64 NumBytes, uint32 Crc)
+{
+	constexpr int64 ChunkSize = 1 << 30;
+	for (int64 Offset = 0; Offset < NumBytes; Offset += ChunkSize)
+	{
+		Crc = FCrc::MemCrc32(Data + Offset, (int32)FMath::Min(ChunkSize, NumBytes - Offset), Crc);
+	}
+	return Crc;
+}
+
+// Versions LoadFromFile understands
+static bool IsSupportedVersion(uint32 Version)
+{
+	return Version >= FSpatialHashHeader::VersionRawIds && Version <= FSpatialHashHeader::VersionCompactEntries;
+}
+
+// Number of samples of the entry offset index (without the end marker)
+static int32 GetNumEntryGroups(uint32 NumEntries, uint32 EntryGroupSize)
+{
+	return (int32)((NumEntries + EntryGroupSize - 1) / EntryGroupSize);
+}
+
+// File offset of the trajectory ID section (raw or compressed)
+static int64 GetTrajectoryIdSectionOffset(const FSpatialHashHeader& Header)
+{
+	if (Header.Version >= FSpatialHashHeader::VersionCompactEntries)
+	{
+		// Header + keys + counts + sampled offsets (with end marker)
+		return sizeof(FSpatialHashHeader) + (int64)Header.NumEntries * (sizeof(uint64) + sizeof(uint32))
+			+ ((int64)GetNumEntryGroups(Header.NumEntries, Header.EntryGroupSize) + 1) * sizeof(uint32);
+	}
+
+	// Header + 16-byte entry records
+	return sizeof(FSpatialHashHeader) + (int64)Header.NumEntries * sizeof(FSpatialHashEntry);
+}
+
+// File offset of the learned index trailer (version 3), right after the trajectory ID section
+static int64 GetLearnedIndexOffset(const FSpatialHashHeader& Header)
+{
+	return GetTrajectoryIdSectionOffset(Header) + Header.CompressedIdBytes;
+}
+
+bool FSpatialHashTable::EncodeTrajectoryIdBlocks(TArray<uint32>& OutGroupOffsets, TArray64<uint8>& OutBlocks) const
+{
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+
+	OutGroupOffsets.Reset(GetNumEntryGroups(Counts.Num(), GroupSize) + 1);
+	OutBlocks.Reset();
+	// Sorted deltas mostly take one or two bytes
+	OutBlocks.Reserve((int64)TrajectoryIds.Num() * 2);
+
+	// Owned trajectory IDs are grouped by cell in entry order
+	int64 CellStart = 0;
+	TArray<uint32> CellIds;
+	for (int32 EntryIndex = 0; EntryIndex < Counts.Num(); ++EntryIndex)
+	{
+		if (OutBlocks.Num() > MAX_uint32)
+		{
+			return false;
+		}
+		if (EntryIndex % GroupSize == 0)
+		{
+			OutGroupOffsets.Add((uint32)OutBlocks.Num());
+		}
+
+		CellIds.Reset();
+		CellIds.Append(TrajectoryIds.GetData() + CellStart, Counts[EntryIndex]);
+		CellIds.Sort();
+		CellStart += Counts[EntryIndex];
+
+		EncodeIdBlock(CellIds, OutBlocks);
+	}
+
+	if (OutBlocks.Num() > MAX_uint32)
+	{
+		return false;
+	}
+	OutGroupOffsets.Add((uint32)OutBlocks.Num());
+
+	return true;
+}
+
+bool FSpatialHashTable::DecodeIdBlocksForEntries(TArrayView<const int32> SortedEntryIndices, const uint8* Blocks, uint64 BlocksOffset,
+	int64 NumBytes, TArray<uint32>& OutTrajectoryIds) const
+{
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	TArrayView<const uint32> GroupOffsets = GetEntryGroupOffsets();
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+
+	// Walk forward through the buffer: Cursor is the cell whose block starts at CursorByte
+	int32 Cursor = -1;
+	int64 CursorByte = 0;
+	for (int32 EntryIndex : SortedEntryIndices)
+	{
+		// Entering a new group restarts the walk at the group's sampled offset
+		if (Cursor < 0 || EntryIndex / GroupSize != Cursor / GroupSize)
+		{
+			Cursor = EntryIndex - EntryIndex % GroupSize;
+			CursorByte = (int64)GroupOffsets[EntryIndex / GroupSize] - (int64)BlocksOffset;
+			if (CursorByte < 0 || CursorByte > NumBytes)
+			{
+				return false;
+			}
+		}
+
+		// Skip the blocks of the preceding cells
+		for (; Cursor < EntryIndex; ++Cursor)
+		{
+			const int64 BlockSize = GetIdBlockSize(Blocks + CursorByte, NumBytes - CursorByte, Counts[Cursor]);
+			if (BlockSize < 0)
+			{
+				return false;
+			}
+			CursorByte += BlockSize;
+		}
+
+		const int32 OutOffset = OutTrajectoryIds.Num();
+		OutTrajectoryIds.AddUninitialized(Counts[EntryIndex]);
+		if (!DecodeIdBlock(Blocks + CursorByte, NumBytes - CursorByte, Counts[EntryIndex], OutTrajectoryIds.GetData() + OutOffset))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FSpatialHashTable::FinalizeEntries()
+{
+	if (Header.EntryGroupSize == 0)
+	{
+		Header.EntryGroupSize = FSpatialHashHeader::DefaultEntryGroupSize;
+	}
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+
+	// Sample the prefix sum of the counts: the index of every GroupSize-th cell's first ID
+	EntryGroupOffsets.Reset(GetNumEntryGroups(EntryCounts.Num(), GroupSize) + 1);
+	uint32 CellStart = 0;
+	for (int32 EntryIndex = 0; EntryIndex < EntryCounts.Num(); ++EntryIndex)
+	{
+		if (EntryIndex % GroupSize == 0)
+		{
+			EntryGroupOffsets.Add(CellStart);
+		}
+		CellStart += EntryCounts[EntryIndex];
+	}
+	EntryGroupOffsets.Add(CellStart);
+
+	// Indices over the previous entries would be stale
+	ResetSearchIndex();
+	ResetLearnedIndex();
+
+	// Built tables hold raw IDs until SaveToFile compresses them
+	Header.NumEntries = EntryKeys.Num();
+	Header.NumTrajectoryIds = TrajectoryIds.Num();
+	Header.CompressedIdBytes = 0;
+
+	if (bUseHashIndex)
+	{
+		BuildHashIndex();
+	}
+}
+
+void FSpatialHashTable::SetEntriesFromRecords(TArrayView<const FSpatialHashEntry> Records)
+{
+	// Legacy files have no group size in their header
+	Header.EntryGroupSize = FSpatialHashHeader::DefaultEntryGroupSize;
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+
+	EntryKeys.SetNumUninitialized(Records.Num());
+	EntryCounts.SetNumUninitialized(Records.Num());
+	EntryGroupOffsets.Reset(GetNumEntryGroups(Records.Num(), GroupSize) + 1);
+	for (int32 EntryIndex = 0; EntryIndex < Records.Num(); ++EntryIndex)
+	{
+		EntryKeys[EntryIndex] = Records[EntryIndex].ZOrderKey;
+		EntryCounts[EntryIndex] = Records[EntryIndex].TrajectoryCount;
+		if (EntryIndex % GroupSize == 0)
+		{
+			EntryGroupOffsets.Add(Records[EntryIndex].StartIndex);
+		}
+	}
+	EntryGroupOffsets.Add(Header.Version >= FSpatialHashHeader::VersionCompressedIds ? Header.CompressedIdBytes : Header.NumTrajectoryIds);
+}
+
+uint32 FSpatialHashTable::GetRawIdStart(int32 EntryIndex) const
+{
+	// Sampled prefix sum of the group, completed from the counts of the preceding cells
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+
+	uint32 CellStart = GetEntryGroupOffsets()[EntryIndex / GroupSize];
+	for (int32 i = EntryIndex - EntryIndex % GroupSize; i < EntryIndex; ++i)
+	{
+		CellStart += Counts[i];
+	}
+	return CellStart;
+}
+
+TArrayView<const uint64> FSpatialHashTable::GetEntryKeys() const
+{
+	return MappedEntryKeys.Num() > 0 ? MappedEntryKeys : TArrayView<const uint64>(EntryKeys);
+}
+
+TArrayView<const uint32> FSpatialHashTable::GetEntryCounts() const
+{
+	return MappedEntryCounts.Num() > 0 ? MappedEntryCounts : TArrayView<const uint32>(EntryCounts);
+}
+
+TArray<FSpatialHashEntry> FSpatialHashTable::GetEntries() const
+{
+	const TArrayView<const uint64> Keys = GetEntryKeys();
+	const TArrayView<const uint32> Counts = GetEntryCounts();
+
+	TArray<FSpatialHashEntry> Result;
+	Result.Reserve(Keys.Num());
+
+	uint32 StartIndex = 0;
+	for (int32 i = 0; i < Keys.Num(); ++i)
+	{
+		Result.Emplace(Keys[i], StartIndex, Counts[i]);
+		StartIndex += Counts[i];
+	}
+
+	return Result;
+}
+
+TArrayView<const uint32> FSpatialHashTable::GetEntryGroupOffsets() const
+{
+	return MappedEntryGroupOffsets.Num() > 0 ? MappedEntryGroupOffsets : TArrayView<const uint32>(EntryGroupOffsets);
+}
+
+int64 FSpatialHashTable::GetEntryMemoryBytes() const
+{
+	return EntryKeys.GetAllocatedSize() + EntryCounts.GetAllocatedSize() + EntryGroupOffsets.GetAllocatedSize()
+		+ SearchKeys.GetAllocatedSize() + SearchEntryIndices.GetAllocatedSize() + HashIndexSlots.GetAllocatedSize()
+		+ LearnedSegments.GetAllocatedSize() + LearnedRadixTable.GetAllocatedSize();
+}
+
+bool FSpatialHashTable::HasResidentTrajectoryIds() const
+{
+	return TrajectoryIds.Num() > 0 || IsMemoryMapped();
+}
+
+TArrayView<const uint32> FSpatialHashTable::GetTrajectoryIdsViewForCell(int32 EntryIndex) const
+{
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	if (EntryIndex < 0 || EntryIndex >= Counts.Num() || HasCompressedTrajectoryIds())
+	{
+		return TArrayView<const uint32>();
+	}
+
+	// Trajectory IDs populated for building/saving take precedence over the mapping
+	TArrayView<const uint32> AllTrajectoryIds = TrajectoryIds.Num() > 0
+		? TArrayView<const uint32>(TrajectoryIds)
+		: MappedTrajectoryIds;
+
+	const uint32 CellStart = GetRawIdStart(EntryIndex);
+	
+	// Validate indices
+	if ((uint64)CellStart + Counts[EntryIndex] > (uint64)AllTrajectoryIds.Num())
+	{
+		return TArrayView<const uint32>();
+	}
+
+	return AllTrajectoryIds.Slice(CellStart, Counts[EntryIndex]);
+}
+
+bool FSpatialHashTable::GetTrajectoryIdsForCell(int32 EntryIndex, TArray<uint32>& OutTrajectoryIds) const
+{
+	OutTrajectoryIds.Reset();
+	
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	if (EntryIndex < 0 || EntryIndex >= Counts.Num())
+	{
+		return false;
+	}
+
+	// Compressed blocks are decoded straight from the mapping, or read from disk first
+	if (HasCompressedTrajectoryIds())
+	{
+		bool bDecoded = false;
+		if (IsMemoryMapped())
+		{
+			bDecoded = DecodeIdBlocksForEntries(MakeArrayView(&EntryIndex, 1), MappedIdBlocks.GetData(), 0, MappedIdBlocks.Num(), OutTrajectoryIds);
+		}
+		else
+		{
+			// The cell's block is found by skipping its predecessors, so the whole group is read
+			TArrayView<const uint32> GroupOffsets = GetEntryGroupOffsets();
+			const int32 Group = EntryIndex / (int32)Header.EntryGroupSize;
+			TArray<uint8> GroupBytes;
+			bDecoded = ReadIdBlocksFromDisk(GroupOffsets[Group], GroupOffsets[Group + 1] - GroupOffsets[Group], GroupBytes)
+				&& DecodeIdBlocksForEntries(MakeArrayView(&EntryIndex, 1), GroupBytes.GetData(), GroupOffsets[Group], GroupBytes.Num(), OutTrajectoryIds);
+		}
+
+		if (!bDecoded)
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::GetTrajectoryIdsForCell: Failed to decode trajectory IDs of cell %d in %s"),
+				EntryIndex, *SourceFilePath);
+			OutTrajectoryIds.Reset();
+			return false;
+		}
+		return true;
+	}
+	
+	// If trajectory IDs are resident (populated for building/saving, or memory-mapped), copy them
+	if (HasResidentTrajectoryIds())
+	{
+		TArrayView<const uint32> CellTrajectoryIds = GetTrajectoryIdsViewForCell(EntryIndex);
+		if (CellTrajectoryIds.Num() != (int32)Counts[EntryIndex])
+		{
+			return false;
+		}
+		OutTrajectoryIds.Append(CellTrajectoryIds.GetData(), CellTrajectoryIds.Num());
+		return true;
+	}
+	
+	// Otherwise, read from disk on-demand
+	return ReadTrajectoryIdsFromDisk(GetRawIdStart(EntryIndex), Counts[EntryIndex], OutTrajectoryIds);
+}
+
+bool FSpatialHashTable::GetTrajectoryIdsForEntryRange(int32 FirstEntry, int32 NumEntries, TArray<uint32>& OutTrajectoryIds) const
+{
+	OutTrajectoryIds.Reset();
+
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	if (FirstEntry < 0 || NumEntries < 0 || FirstEntry > Counts.Num() - NumEntries)
+	{
+		return false;
+	}
+
+	uint64 NumIds = 0;
+	for (int32 EntryIndex = FirstEntry; EntryIndex < FirstEntry + NumEntries; ++EntryIndex)
+	{
+		NumIds += Counts[EntryIndex];
+	}
+	if (NumIds > (uint64)MAX_int32)
+	{
+		return false;
+	}
+	OutTrajectoryIds.Reserve((int32)NumIds);
+
+	if (HasCompressedTrajectoryIds())
+	{
+		TArray<int32> EntryIndices;
+		EntryIndices.SetNumUninitialized(NumEntries);
+		for (int32 Index = 0; Index < NumEntries; ++Index)
+		{
+			EntryIndices[Index] = FirstEntry + Index;
+		}
+
+		bool bDecoded = true;
+		if (IsMemoryMapped())
+		{
+			bDecoded = DecodeIdBlocksForEntries(EntryIndices, MappedIdBlocks.GetData(), 0, MappedIdBlocks.Num(), OutTrajectoryIds);
+		}
+		else
+		{
+			// Read whole groups in bounded chunks, each decoded as soon as it is read
+			constexpr int32 GroupsPerRead = 256;
+			TArrayView<const uint32> GroupOffsets = GetEntryGroupOffsets();
+			const int32 GroupSize = (int32)Header.EntryGroupSize;
+			const int32 EndEntry = FirstEntry + NumEntries;
+			TArray<uint8> GroupBytes;
+			for (int32 ChunkStart = FirstEntry; ChunkStart < EndEntry && bDecoded; )
+			{
+				const int32 FirstGroup = ChunkStart / GroupSize;
+				const int32 ChunkEnd = (int32)FMath::Min<int64>(EndEntry, (int64)(FirstGroup + GroupsPerRead) * GroupSize);
+				const int32 EndGroup = (ChunkEnd - 1) / GroupSize + 1;
+				bDecoded = ReadIdBlocksFromDisk(GroupOffsets[FirstGroup], GroupOffsets[EndGroup] - GroupOffsets[FirstGroup], GroupBytes)
+					&& DecodeIdBlocksForEntries(MakeArrayView(EntryIndices.GetData() + (ChunkStart - FirstEntry), ChunkEnd - ChunkStart),
+						GroupBytes.GetData(), GroupOffsets[FirstGroup], GroupBytes.Num(), OutTrajectoryIds);
+				ChunkStart = ChunkEnd;
+			}
+		}
+
+		if (!bDecoded)
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::GetTrajectoryIdsForEntryRange: Failed to decode trajectory IDs of cells %d-%d in %s"),
+				FirstEntry, FirstEntry + NumEntries - 1, *SourceFilePath);
+			OutTrajectoryIds.Reset();
+			return false;
+		}
+		return true;
+	}
+
+	// Resident IDs (populated for building/saving, or memory-mapped) are copied cell by cell
+	if (HasResidentTrajectoryIds())
+	{
+		for (int32 EntryIndex = FirstEntry; EntryIndex < FirstEntry + NumEntries; ++EntryIndex)
+		{
+			TArrayView<const uint32> CellTrajectoryIds = GetTrajectoryIdsViewForCell(EntryIndex);
+			if (CellTrajectoryIds.Num() != (int32)Counts[EntryIndex])
+			{
+				OutTrajectoryIds.Reset();
+				return false;
+			}
+			OutTrajectoryIds.Append(CellTrajectoryIds.GetData(), CellTrajectoryIds.Num());
+		}
+		return true;
+	}
+
+	// Otherwise, the cells' IDs are one contiguous range on disk
+	return NumIds == 0 || ReadTrajectoryIdsFromDisk(GetRawIdStart(FirstEntry), (uint32)NumIds, OutTrajectoryIds);
+}
+
+bool FSpatialHashTable::QueryAtPosition(const FVector& WorldPos, TArray<uint32>& OutTrajectoryIds) const
+{
+	OutTrajectoryIds.Reset();
+	
+	// Convert world position to cell coordinates
+	int32 CellX, CellY, CellZ;
+	WorldToCellCoordinates(WorldPos, Header.GetBBoxMin(), Header.CellSize, CellX, CellY, CellZ);
+	
+	// Calculate Z-Order key
+	uint64 Key = CalculateZOrderKey(CellX, CellY, CellZ);
+	
+	// Find entry
+	int32 EntryIndex = FindEntry(Key);
+	if (EntryIndex >= 0)
+	{
+		return GetTrajectoryIdsForCell(EntryIndex, OutTrajectoryIds);
+	}
+	
+	return false;
+}
+
+int32 FSpatialHashTable::QueryTrajectoryIdsInRadius(const FVector& WorldPos, float Radius, TArray<uint32>& OutTrajectoryIds) const
+{
+	// Per-thread working memory keeps repeated queries from reallocating
+	static thread_local FQueryScratch ThreadScratch;
+	return QueryTrajectoryIdsInRadius(WorldPos, Radius, OutTrajectoryIds, ThreadScratch);
+}
+
+int32 FSpatialHashTable::QueryTrajectoryIdsInRadius(const FVector& WorldPos, float Radius, TArray<uint32>& OutTrajectoryIds, FQueryScratch& Scratch) const
+{
+	OutTrajectoryIds.Reset();
+	
+	// First pass: collect every occupied cell that intersects the query sphere
+	FindEntriesInRadius(WorldPos, Radius, Scratch.EntryIndices);
+	
+	// Second pass: fetch trajectory IDs of all matched cells at once, straight into the output
+	if (!GatherTrajectoryIdsForEntries(Scratch.EntryIndices, OutTrajectoryIds, Scratch))
+	{
+		return 0;
+	}
+	
+	// Deduplicate in place - trajectories spanning several cells appear more than once
+	OutTrajectoryIds.Sort();
+	int32 NumUnique = 0;
+	for (int32 i = 0; i < OutTrajectoryIds.Num(); ++i)
+	{
+		if (NumUnique == 0 || OutTrajectoryIds[i] != OutTrajectoryIds[NumUnique - 1])
+		{
+			OutTrajectoryIds[NumUnique++] = OutTrajectoryIds[i];
+		}
+	}
+	OutTrajectoryIds.SetNum(NumUnique, EAllowShrinking::No);
+	
+	return OutTrajectoryIds.Num();
+}
+
+int32 FSpatialHashTable::FindEntriesInRadius(const FVector& WorldPos, float Radius, TArray<int32>& OutEntryIndices) const
+{
+	OutEntryIndices.Reset();
+
+	const FVector BBoxMin = Header.GetBBoxMin();
+	const float CellSize = Header.CellSize;
+
+	// Cells covered by the bounding box of the query sphere
+	FIntVector MinCell, MaxCell;
+	WorldToCellCoordinates(WorldPos - FVector(Radius), BBoxMin, CellSize, MinCell.X, MinCell.Y, MinCell.Z);
+	WorldToCellCoordinates(WorldPos + FVector(Radius), BBoxMin, CellSize, MaxCell.X, MaxCell.Y, MaxCell.Z);
+
+	if (FindEntriesInCellBox(MinCell, MaxCell, OutEntryIndices) == 0)
+	{
+		return 0;
+	}
+
+	// Keep only cells whose AABB is within Radius of the query point (corner cells of the box often are not).
+	// Filtered in place so no second array is needed.
+	TArrayView<const uint64> SortedKeys = GetEntryKeys();
+	const double RadiusSq = (double)Radius * Radius;
+	int32 NumKept = 0;
+
+	// Keys are decoded in blocks so the batch decoder can be used without heap allocations
+	constexpr int32 BlockSize = 64;
+	uint64 BlockKeys[BlockSize];
+	int32 BlockCellX[BlockSize];
+	int32 BlockCellY[BlockSize];
+	int32 BlockCellZ[BlockSize];
+
+	for (int32 BlockStart = 0; BlockStart < OutEntryIndices.Num(); BlockStart += BlockSize)
+	{
+		const int32 NumInBlock = FMath::Min(BlockSize, OutEntryIndices.Num() - BlockStart);
+		for (int32 j = 0; j < NumInBlock; ++j)
+		{
+			BlockKeys[j] = SortedKeys[OutEntryIndices[BlockStart + j]];
+		}
+		DecodeZOrderKeysBatch(MakeArrayView(BlockKeys, NumInBlock), BlockCellX, BlockCellY, BlockCellZ);
+
+		for (int32 j = 0; j < NumInBlock; ++j)
+		{
+			const FVector CellMin = BBoxMin + FVector(BlockCellX[j], BlockCellY[j], BlockCellZ[j]) * CellSize;
+			const FBox CellBounds(CellMin, CellMin + FVector(CellSize));
+			if (CellBounds.ComputeSquaredDistanceToPoint(WorldPos) <= RadiusSq)
+			{
+				// NumKept never overtakes the block being read, so filtering in place is safe
+				OutEntryIndices[NumKept++] = OutEntryIndices[BlockStart + j];
+			}
+		}
+	}
+	OutEntryIndices.SetNum(NumKept, EAllowShrinking::No);
+
+	return NumKept;
+}
+
+bool FSpatialHashTable::GatherTrajectoryIdsForEntries(TArray<int32>& EntryIndices, TArray<uint32>& OutTrajectoryIds, FQueryScratch& Scratch) const
+{
+	OutTrajectoryIds.Reset();
+
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	const bool bCompressed = HasCompressedTrajectoryIds();
+
+	// Cells are stored in entry order in both ID layouts, so this is also file order
+	EntryIndices.Sort();
+
+	// Mapped compressed blocks need no I/O - decode each cell straight into the output
+	if (bCompressed && IsMemoryMapped())
+	{
+		if (!DecodeIdBlocksForEntries(EntryIndices, MappedIdBlocks.GetData(), 0, MappedIdBlocks.Num(), OutTrajectoryIds))
+		{
+			OutTrajectoryIds.Reset();
+			return false;
+		}
+		return true;
+	}
+
+	// Resident trajectory IDs need no I/O - just copy the slices
+	if (!bCompressed && HasResidentTrajectoryIds())
+	{
+		for (int32 EntryIndex : EntryIndices)
+		{
+			TArrayView<const uint32> CellTrajectoryIds = GetTrajectoryIdsViewForCell(EntryIndex);
+			OutTrajectoryIds.Append(CellTrajectoryIds.GetData(), CellTrajectoryIds.Num());
+		}
+		return true;
+	}
+
+	if (EntryIndices.Num() == 0)
+	{
+		return true;
+	}
+
+	// Ranges are in IDs for raw files. Compressed blocks are located by skipping their
+	// predecessors, so compressed ranges cover whole entry groups and are in bytes.
+	TArrayView<const uint32> GroupOffsets = GetEntryGroupOffsets();
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+	const uint64 CoalesceGap = bCompressed ? (uint64)ReadCoalesceGap * sizeof(uint32) : ReadCoalesceGap;
+	auto GetCellRange = [this, &Counts, &GroupOffsets, GroupSize, bCompressed](int32 EntryIndex, uint64& OutStart, uint64& OutEnd)
+	{
+		if (bCompressed)
+		{
+			OutStart = GroupOffsets[EntryIndex / GroupSize];
+			OutEnd = GroupOffsets[EntryIndex / GroupSize + 1];
+		}
+		else
+		{
+			OutStart = GetRawIdStart(EntryIndex);
+			OutEnd = OutStart + Counts[EntryIndex];
+		}
+	};
+
+	// Merge adjacent or nearly adjacent cells into one sequential read each.
+	// Reading a gap of up to ReadCoalesceGap unused IDs is cheaper than another seek.
+	int32 RangeFirst = 0;
+	while (RangeFirst < EntryIndices.Num())
+	{
+		uint64 RangeStart, RangeEnd;
+		GetCellRange(EntryIndices[RangeFirst], RangeStart, RangeEnd);
+
+		int32 RangeLast = RangeFirst;
+		while (RangeLast + 1 < EntryIndices.Num())
+		{
+			uint64 NextStart, NextEnd;
+			GetCellRange(EntryIndices[RangeLast + 1], NextStart, NextEnd);
+			if (NextStart > RangeEnd + CoalesceGap)
+			{
+				break;
+			}
+			RangeEnd = FMath::Max(RangeEnd, NextEnd);
+			++RangeLast;
+		}
+
+		if (bCompressed)
+		{
+			if (!ReadIdBlocksFromDisk((uint32)RangeStart, (uint32)(RangeEnd - RangeStart), Scratch.BlockBuffer) ||
+				!DecodeIdBlocksForEntries(MakeArrayView(EntryIndices.GetData() + RangeFirst, RangeLast - RangeFirst + 1),
+					Scratch.BlockBuffer.GetData(), RangeStart, Scratch.BlockBuffer.Num(), OutTrajectoryIds))
+			{
+				UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::GatherTrajectoryIdsForEntries: Failed to decode trajectory IDs in %s"),
+					*SourceFilePath);
+				OutTrajectoryIds.Reset();
+				return false;
+			}
+		}
+		else
+		{
+			if (!ReadTrajectoryIdsFromDisk((uint32)RangeStart, (uint32)(RangeEnd - RangeStart), Scratch.RangeBuffer))
+			{
+				OutTrajectoryIds.Reset();
+				return false;
+			}
+
+			// Copy each cell's slice out of the merged range
+			for (int32 i = RangeFirst; i <= RangeLast; ++i)
+			{
+				const int32 EntryIndex = EntryIndices[i];
+				OutTrajectoryIds.Append(Scratch.RangeBuffer.GetData() + (GetRawIdStart(EntryIndex) - RangeStart), Counts[EntryIndex]);
+			}
+		}
+
+		RangeFirst = RangeLast + 1;
+	}
+
+	return true;
 }
 
-bool FSpatialHashTable::GetTrajectoryIdsForCell(int32 EntryIndex, TArray<uint32>& OutTrajectoryIds) const
+bool FSpatialHashTable::SaveToFile(const FString& Filename, uint32* OutChecksum, int64* OutFileSize, uint32 FileVersion) const
 {
-	OutTrajectoryIds.Reset();
-	
-	if (EntryIndex < 0 || EntryIndex >= Entries.Num())
+	if (FileVersion != FSpatialHashHeader::VersionRawIds && FileVersion != FSpatialHashHeader::VersionCompactEntries)
 	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Cannot write format version %u"), FileVersion);
 		return false;
 	}
 
-	const FSpatialHashEntry& Entry = Entries[EntryIndex];
-	
-	// If TrajectoryIds array is populated (e.g., for building/saving), use it
-	if (TrajectoryIds.Num() > 0)
+	// Validate before saving
+	if (!Validate())
 	{
-		// Validate indices
-		if (Entry.StartIndex < (uint32)TrajectoryIds.Num() &&
-			Entry.StartIndex + Entry.TrajectoryCount <= (uint32)TrajectoryIds.Num())
-		{
-			OutTrajectoryIds.Reserve(Entry.TrajectoryCount);
-			for (uint32 i = 0; i < Entry.TrajectoryCount; ++i)
-			{
-				OutTrajectoryIds.Add(TrajectoryIds[Entry.StartIndex + i]);
-			}
-			return true;
-		}
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Validation failed"));
 		return false;
 	}
-	
-	// Otherwise, read from disk on-demand
-	return ReadTrajectoryIdsFromDisk(Entry.StartIndex, Entry.TrajectoryCount, OutTrajectoryIds);
-}
 
-bool FSpatialHashTable::QueryAtPosition(const FVector& WorldPos, TArray<uint32>& OutTrajectoryIds) const
-{
-	OutTrajectoryIds.Reset();
-	
-	// Convert world position to cell coordinates
-	int32 CellX, CellY, CellZ;
-	WorldToCellCoordinates(WorldPos, Header.GetBBoxMin(), Header.CellSize, CellX, CellY, CellZ);
-	
-	// Calculate Z-Order key
-	uint64 Key = CalculateZOrderKey(CellX, CellY, CellZ);
-	
-	// Find entry
-	int32 EntryIndex = FindEntry(Key);
-	if (EntryIndex >= 0)
+	if (TrajectoryIds.Num() != (int32)Header.NumTrajectoryIds)
 	{
-		return GetTrajectoryIdsForCell(EntryIndex, OutTrajectoryIds);
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Trajectory IDs are not resident"));
+		return false;
 	}
-	
-	return false;
-}
 
-int32 FSpatialHashTable::QueryTrajectoryIdsInRadius(const FVector& WorldPos, float Radius, TArray<uint32>& OutTrajectoryIds) const
-{
-	OutTrajectoryIds.Reset();
-	
-	// Calculate the bounding box of cells that could overlap with the query radius
-	FVector BBoxMin = Header.GetBBoxMin();
-	float CellSize = Header.CellSize;
-	
-	// Calculate the cell range that encompasses the query sphere
-	int32 CenterCellX, CenterCellY, CenterCellZ;
-	WorldToCellCoordinates(WorldPos, BBoxMin, CellSize, CenterCellX, CenterCellY, CenterCellZ);
-	
-	// Calculate how many cells to check in each direction
-	// Add 1 to ensure we cover the full radius even at cell boundaries
-	int32 CellRadius = FMath::CeilToInt(Radius / CellSize) + 1;
-	
-	// Use a set to collect unique trajectory IDs
-	TSet<uint32> UniqueTrajectoryIds;
-	
-	// Iterate over all cells within the bounding box
-	for (int32 dx = -CellRadius; dx <= CellRadius; ++dx)
+	FSpatialHashHeader FileHeader = Header;
+	FileHeader.Version = FileVersion;
+
+	// Sections in file order
+	struct FSection
+	{
+		const uint8* Data;
+		int64 NumBytes;
+		const TCHAR* Name;
+	};
+	TArray<FSection, TInlineAllocator<6>> Sections;
+	Sections.Add({ reinterpret_cast<const uint8*>(&FileHeader), (int64)sizeof(FSpatialHashHeader), TEXT("header") });
+
+	TArray<uint32> BlockGroupOffsets;
+	TArray64<uint8> IdBlocks;
+	TArray<uint8> LearnedIndex;
+	TArray<FSpatialHashEntry> Records;
+	if (FileVersion == FSpatialHashHeader::VersionRawIds)
+	{
+		// Format version 1: 16-byte entry records, then the raw trajectory IDs (fields after
+		// NumTrajectoryIds were reserved and are zero)
+		FileHeader.CompressedIdBytes = 0;
+		FileHeader.EntryGroupSize = 0;
+		FileHeader.LearnedIndexBytes = 0;
+
+		Records = GetEntries();
+		Sections.Add({ reinterpret_cast<const uint8*>(Records.GetData()), (int64)Records.Num() * (int64)sizeof(FSpatialHashEntry), TEXT("entries") });
+		Sections.Add({ reinterpret_cast<const uint8*>(TrajectoryIds.GetData()), (int64)TrajectoryIds.Num() * (int64)sizeof(uint32), TEXT("trajectory IDs") });
+	}
+	else
 	{
-		for (int32 dy = -CellRadius; dy <= CellRadius; ++dy)
+		// Format version 3: keys, counts, sampled block offsets, then per-cell compressed blocks
+		if (!EncodeTrajectoryIdBlocks(BlockGroupOffsets, IdBlocks))
 		{
-			for (int32 dz = -CellRadius; dz <= CellRadius; ++dz)
-			{
-				int32 CellX = CenterCellX + dx;
-				int32 CellY = CenterCellY + dy;
-				int32 CellZ = CenterCellZ + dz;
-				
-				// Skip cells that are outside the valid range
-				if (CellX < 0 || CellY < 0 || CellZ < 0)
-					continue;
-				
-				// Calculate Z-Order key for this cell
-				uint64 Key = CalculateZOrderKey(CellX, CellY, CellZ);
-				
-				// Find entry for this cell
-				int32 EntryIndex = FindEntry(Key);
-				if (EntryIndex >= 0)
-				{
-					// Get trajectory IDs for this cell
-					TArray<uint32> CellTrajectoryIds;
-					if (GetTrajectoryIdsForCell(EntryIndex, CellTrajectoryIds))
-					{
-						// Add to unique set
-						for (uint32 TrajId : CellTrajectoryIds)
-						{
-							UniqueTrajectoryIds.Add(TrajId);
-						}
-					}
-				}
-			}
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Compressed trajectory IDs exceed 4 GB"));
+			return false;
 		}
-	}
-	
-	// Convert set to array
-	OutTrajectoryIds = UniqueTrajectoryIds.Array();
-	
-	return OutTrajectoryIds.Num();
-}
 
+		if (HasLearnedIndex())
+		{
+			WriteLearnedIndex(LearnedIndex);
+		}
 
-bool FSpatialHashTable::SaveToFile(const FString& Filename) const
-{
-	// Validate before saving
-	if (!Validate())
-	{
-		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Validation failed"));
-		return false;
+		FileHeader.CompressedIdBytes = (uint32)IdBlocks.Num();
+		FileHeader.LearnedIndexBytes = (uint32)LearnedIndex.Num();
+
+		TArrayView<const uint64> Keys = GetEntryKeys();
+		TArrayView<const uint32> Counts = GetEntryCounts();
+		Sections.Add({ reinterpret_cast<const uint8*>(Keys.GetData()), (int64)Keys.Num() * (int64)sizeof(uint64), TEXT("entry keys") });
+		Sections.Add({ reinterpret_cast<const uint8*>(Counts.GetData()), (int64)Counts.Num() * (int64)sizeof(uint32), TEXT("entry counts") });
+		Sections.Add({ reinterpret_cast<const uint8*>(BlockGroupOffsets.GetData()), (int64)BlockGroupOffsets.Num() * (int64)sizeof(uint32), TEXT("entry group offsets") });
+		Sections.Add({ IdBlocks.GetData(), IdBlocks.Num(), TEXT("trajectory IDs") });
+		Sections.Add({ LearnedIndex.GetData(), (int64)LearnedIndex.Num(), TEXT("learned index") });
 	}
 
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
@@ -235,6 +1777,9 @@ bool FSpatialHashTable::SaveToFile(const FString& Filename) const
 		PlatformFile.CreateDirectoryTree(*Directory);
 	}
 
+	// Drop any pooled read handle first - some platforms refuse to write a file that is open for reading
+	FSpatialHashFileHandlePool::Get().Release(Filename);
+
 	// Open file for writing
 	IFileHandle* FileHandle = PlatformFile.OpenWrite(*Filename);
 	if (!FileHandle)
@@ -244,47 +1789,69 @@ bool FSpatialHashTable::SaveToFile(const FString& Filename) const
 	}
 
 	bool bSuccess = true;
-
-	// Write header
-	if (!FileHandle->Write(reinterpret_cast<const uint8*>(&Header), sizeof(FSpatialHashHeader)))
+	for (const FSection& Section : Sections)
 	{
-		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Failed to write header"));
-		bSuccess = false;
-	}
-
-	// Write hash table entries
-	if (bSuccess && Entries.Num() > 0)
-	{
-		if (!FileHandle->Write(reinterpret_cast<const uint8*>(Entries.GetData()), 
-			Entries.Num() * sizeof(FSpatialHashEntry)))
+		if (Section.NumBytes > 0 && !FileHandle->Write(Section.Data, Section.NumBytes))
 		{
-			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Failed to write entries"));
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Failed to write %s"), Section.Name);
 			bSuccess = false;
+			break;
 		}
 	}
 
-	// Write trajectory IDs
-	if (bSuccess && TrajectoryIds.Num() > 0)
+	delete FileHandle;
+
+	if (bSuccess)
 	{
-		if (!FileHandle->Write(reinterpret_cast<const uint8*>(TrajectoryIds.GetData()), 
-			TrajectoryIds.Num() * sizeof(uint32)))
+		// Chained over the same byte ranges as written, so it equals the CRC of the file
+		uint32 Checksum = 0;
+		int64 FileSize = 0;
+		for (const FSection& Section : Sections)
 		{
-			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::SaveToFile: Failed to write trajectory IDs"));
-			bSuccess = false;
+			Checksum = MemCrc32Chunked(Section.Data, Section.NumBytes, Checksum);
+			FileSize += Section.NumBytes;
 		}
+		if (OutChecksum)
+		{
+			*OutChecksum = Checksum;
+		}
+		if (OutFileSize)
+		{
+			*OutFileSize = FileSize;
+		}
+
+		UE_LOG(LogTemp, Log, TEXT("FSpatialHashTable::SaveToFile: Successfully saved to %s (version %u, %u trajectory IDs, %lld bytes)"),
+			*Filename, FileVersion, Header.NumTrajectoryIds, FileSize);
 	}
 
-	delete FileHandle;
+	return bSuccess;
+}
 
-	if (bSuccess)
+bool FSpatialHashTable::LoadHeaderFromFile(const FString& Filename, FSpatialHashHeader& OutHeader)
+{
+	TUniquePtr<IFileHandle> FileHandle(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Filename));
+	if (!FileHandle)
 	{
-		UE_LOG(LogTemp, Log, TEXT("FSpatialHashTable::SaveToFile: Successfully saved to %s"), *Filename);
+		return false;
 	}
 
-	return bSuccess;
+	if (!FileHandle->Read(reinterpret_cast<uint8*>(&OutHeader), sizeof(FSpatialHashHeader)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::LoadHeaderFromFile: Failed to read header of %s"), *Filename);
+		return false;
+	}
+
+	if (OutHeader.Magic != 0x54534854 || !IsSupportedVersion(OutHeader.Version))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::LoadHeaderFromFile: Invalid header in %s (magic 0x%08X, version %u)"),
+			*Filename, OutHeader.Magic, OutHeader.Version);
+		return false;
+	}
+
+	return true;
 }
 
-bool FSpatialHashTable::LoadFromFile(const FString& Filename)
+bool FSpatialHashTable::LoadFromFile(const FString& Filename, const FLoadOptions& Options)
 {
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 	
@@ -295,9 +1862,49 @@ bool FSpatialHashTable::LoadFromFile(const FString& Filename)
 		return false;
 	}
 
+	// Drop any state from a previous load
+	UnmapFile();
+	EntryKeys.Reset();
+	EntryCounts.Reset();
+	EntryGroupOffsets.Reset();
+	TrajectoryIds.Reset();
+	ResetSearchIndex();
+	ResetHashIndex();
+	ResetLearnedIndex();
+
 	// Store the file path for on-demand loading
 	SourceFilePath = Filename;
 
+	// Memory-mapped mode: entries and trajectory IDs become views into the mapping
+	if (Options.bMemoryMap)
+	{
+		if (MapFile(Filename))
+		{
+			if (!Validate())
+			{
+				UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Validation failed after mapping %s"), *Filename);
+				UnmapFile();
+				return false;
+			}
+
+			if (Options.bBuildSearchIndex)
+			{
+				BuildSearchIndex();
+			}
+
+			if (bUseHashIndex)
+			{
+				BuildHashIndex();
+			}
+
+			UE_LOG(LogTemp, Log, TEXT("FSpatialHashTable::LoadFromFile: Successfully memory-mapped %s"), *Filename);
+			return true;
+		}
+
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::LoadFromFile: Memory mapping failed for %s, falling back to regular loading"),
+			*Filename);
+	}
+
 	// Open file for reading
 	IFileHandle* FileHandle = PlatformFile.OpenRead(*Filename);
 	if (!FileHandle)
@@ -323,7 +1930,7 @@ bool FSpatialHashTable::LoadFromFile(const FString& Filename)
 			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Invalid magic number: 0x%08X"), Header.Magic);
 			bSuccess = false;
 		}
-		else if (Header.Version != 1)
+		else if (!IsSupportedVersion(Header.Version))
 		{
 			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Unsupported version: %u"), Header.Version);
 			bSuccess = false;
@@ -331,20 +1938,60 @@ bool FSpatialHashTable::LoadFromFile(const FString& Filename)
 	}
 
 	// Read hash table entries
-	if (bSuccess && Header.NumEntries > 0)
+	if (bSuccess && Header.Version >= FSpatialHashHeader::VersionCompactEntries)
 	{
-		Entries.SetNum(Header.NumEntries);
-		if (!FileHandle->Read(reinterpret_cast<uint8*>(Entries.GetData()), 
-			Header.NumEntries * sizeof(FSpatialHashEntry)))
+		if (Header.EntryGroupSize == 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Invalid entry group size"));
+			bSuccess = false;
+		}
+		else
+		{
+			EntryKeys.SetNumUninitialized(Header.NumEntries);
+			EntryCounts.SetNumUninitialized(Header.NumEntries);
+			EntryGroupOffsets.SetNumUninitialized(GetNumEntryGroups(Header.NumEntries, Header.EntryGroupSize) + 1);
+			if (!FileHandle->Read(reinterpret_cast<uint8*>(EntryKeys.GetData()), EntryKeys.NumBytes()) ||
+				!FileHandle->Read(reinterpret_cast<uint8*>(EntryCounts.GetData()), EntryCounts.NumBytes()) ||
+				!FileHandle->Read(reinterpret_cast<uint8*>(EntryGroupOffsets.GetData()), EntryGroupOffsets.NumBytes()))
+			{
+				UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Failed to read entries"));
+				bSuccess = false;
+			}
+		}
+	}
+	else if (bSuccess)
+	{
+		// Version 1 and 2 store 16-byte entry records
+		TArray<FSpatialHashEntry> Records;
+		Records.SetNumUninitialized(Header.NumEntries);
+		if (Header.NumEntries > 0 && !FileHandle->Read(reinterpret_cast<uint8*>(Records.GetData()), Records.NumBytes()))
 		{
 			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Failed to read entries"));
 			bSuccess = false;
 		}
+		else
+		{
+			SetEntriesFromRecords(Records);
+		}
 	}
 
 	// Skip loading trajectory IDs to save memory - they will be read on-demand
 	// Note: TrajectoryIds array is already empty from initialization
 
+	// The learned index trailer follows the trajectory IDs
+	if (bSuccess && Header.Version >= FSpatialHashHeader::VersionCompactEntries && Header.LearnedIndexBytes > 0)
+	{
+		TArray<uint8> LearnedIndex;
+		LearnedIndex.SetNumUninitialized(Header.LearnedIndexBytes);
+		if (!FileHandle->Seek(GetLearnedIndexOffset(Header)) ||
+			!FileHandle->Read(LearnedIndex.GetData(), LearnedIndex.Num()) ||
+			!ReadLearnedIndex(LearnedIndex.GetData(), LearnedIndex.Num()))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::LoadFromFile: Failed to read learned index"));
+			bSuccess = false;
+		}
+	}
+
 	delete FileHandle;
 
 	// Validate loaded data
@@ -354,6 +2001,16 @@ bool FSpatialHashTable::LoadFromFile(const FString& Filename)
 		bSuccess = false;
 	}
 
+	if (bSuccess && Options.bBuildSearchIndex)
+	{
+		BuildSearchIndex();
+	}
+
+	if (bSuccess && bUseHashIndex)
+	{
+		BuildHashIndex();
+	}
+
 	if (bSuccess)
 	{
 		UE_LOG(LogTemp, Log, TEXT("FSpatialHashTable::LoadFromFile: Successfully loaded from %s (trajectory IDs not loaded for memory optimization)"), *Filename);
@@ -371,7 +2028,7 @@ bool FSpatialHashTable::Validate() const
 		return false;
 	}
 
-	if (Header.Version != 1)
+	if (!IsSupportedVersion(Header.Version))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Unsupported version"));
 		return false;
@@ -383,7 +2040,17 @@ bool FSpatialHashTable::Validate() const
 		return false;
 	}
 
-	if (Header.NumEntries != (uint32)Entries.Num())
+	if (Header.EntryGroupSize == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Invalid entry group size"));
+		return false;
+	}
+
+	TArrayView<const uint64> Keys = GetEntryKeys();
+	TArrayView<const uint32> Counts = GetEntryCounts();
+	TArrayView<const uint32> GroupOffsets = GetEntryGroupOffsets();
+
+	if (Header.NumEntries != (uint32)Keys.Num() || Header.NumEntries != (uint32)Counts.Num())
 	{
 		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Entry count mismatch"));
 		return false;
@@ -397,50 +2064,56 @@ bool FSpatialHashTable::Validate() const
 	}
 
 	// Check that entries are sorted
-	for (int32 i = 1; i < Entries.Num(); ++i)
+	for (int32 i = 1; i < Keys.Num(); ++i)
 	{
-		if (Entries[i].ZOrderKey <= Entries[i - 1].ZOrderKey)
+		if (Keys[i] <= Keys[i - 1])
 		{
 			UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Entries not sorted at index %d"), i);
 			return false;
 		}
 	}
 
-	// Check that all entry indices are valid (only if TrajectoryIds array is populated)
-	if (TrajectoryIds.Num() > 0)
+	// Counts must add up to the number of trajectory IDs
+	uint64 TotalCount = 0;
+	for (uint32 Count : Counts)
 	{
-		for (const FSpatialHashEntry& Entry : Entries)
-		{
-			if (Entry.StartIndex >= (uint32)TrajectoryIds.Num())
-			{
-				UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Invalid start index"));
-				return false;
-			}
+		TotalCount += Count;
+	}
+	if (TotalCount != Header.NumTrajectoryIds)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Entry counts do not match trajectory ID count"));
+		return false;
+	}
 
-			if (Entry.StartIndex + Entry.TrajectoryCount > (uint32)TrajectoryIds.Num())
-			{
-				UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Entry exceeds trajectory IDs array"));
-				return false;
-			}
-		}
+	// Sampled offsets are ascending and end at the end of the trajectory ID section
+	const int32 GroupSize = (int32)Header.EntryGroupSize;
+	const uint32 SectionEnd = HasCompressedTrajectoryIds() ? Header.CompressedIdBytes : Header.NumTrajectoryIds;
+	if (GroupOffsets.Num() != GetNumEntryGroups(Header.NumEntries, GroupSize) + 1 || GroupOffsets.Last() != SectionEnd)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Invalid entry offset index"));
+		return false;
 	}
-	else
+
+	uint64 CellStart = 0;
+	for (int32 EntryIndex = 0; EntryIndex < Counts.Num(); ++EntryIndex)
 	{
-		// When TrajectoryIds array is empty (on-demand loading mode), validate against header
-		for (const FSpatialHashEntry& Entry : Entries)
+		if (EntryIndex % GroupSize == 0)
 		{
-			if (Entry.StartIndex >= Header.NumTrajectoryIds)
+			const uint32 GroupOffset = GroupOffsets[EntryIndex / GroupSize];
+			if (GroupOffset > GroupOffsets[EntryIndex / GroupSize + 1])
 			{
-				UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Invalid start index"));
+				UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Entry offset index not sorted at entry %d"), EntryIndex);
 				return false;
 			}
 
-			if (Entry.StartIndex + Entry.TrajectoryCount > Header.NumTrajectoryIds)
+			// Raw offsets are exact prefix sums of the counts
+			if (!HasCompressedTrajectoryIds() && GroupOffset != CellStart)
 			{
-				UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Entry exceeds trajectory IDs array"));
+				UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::Validate: Invalid start index at entry %d"), EntryIndex);
 				return false;
 			}
 		}
+		CellStart += Counts[EntryIndex];
 	}
 
 	return true;
@@ -469,42 +2142,183 @@ bool FSpatialHashTable::ReadTrajectoryIdsFromDisk(uint32 StartIndex, uint32 Coun
 		return false;
 	}
 
+	// Trajectory IDs array follows the entry sections
+	int64 TrajectoryIdsOffset = GetTrajectoryIdSectionOffset(Header);
+	int64 ReadOffset = TrajectoryIdsOffset + ((int64)StartIndex * sizeof(uint32));
+
+	// Positional read through the shared handle pool - the file stays open across cells and queries
+	OutTrajectoryIds.SetNum(Count);
+	if (!FSpatialHashFileHandlePool::Get().ReadAt(SourceFilePath, ReadOffset, Count * sizeof(uint32),
+		reinterpret_cast<uint8*>(OutTrajectoryIds.GetData())))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadTrajectoryIdsFromDisk: Failed to read %u trajectory IDs from %s"),
+			Count, *SourceFilePath);
+		OutTrajectoryIds.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FSpatialHashTable::ReadIdBlocksFromDisk(uint32 ByteOffset, uint32 NumBytes, TArray<uint8>& OutBytes) const
+{
+	OutBytes.Reset();
+
+	if (SourceFilePath.IsEmpty())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadIdBlocksFromDisk: No source file path set"));
+		return false;
+	}
+
+	if (NumBytes == 0)
+	{
+		return true; // Nothing to read
+	}
+
+	if ((uint64)ByteOffset + NumBytes > Header.CompressedIdBytes)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadIdBlocksFromDisk: Invalid range [%u, %llu) for section size %u"),
+			ByteOffset, (uint64)ByteOffset + NumBytes, Header.CompressedIdBytes);
+		return false;
+	}
+
+	// Compressed blocks follow the entry sections
+	const int64 ReadOffset = GetTrajectoryIdSectionOffset(Header) + ByteOffset;
+
+	OutBytes.SetNumUninitialized(NumBytes);
+	if (!FSpatialHashFileHandlePool::Get().ReadAt(SourceFilePath, ReadOffset, NumBytes, OutBytes.GetData()))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadIdBlocksFromDisk: Failed to read %u bytes from %s"),
+			NumBytes, *SourceFilePath);
+		OutBytes.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FSpatialHashTable::MapFile(const FString& Filename)
+{
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
-	
-	// Open file for reading
-	IFileHandle* FileHandle = PlatformFile.OpenRead(*SourceFilePath);
-	if (!FileHandle)
+
+	IMappedFileHandle* RawMappedFile = PlatformFile.OpenMapped(*Filename);
+	if (!RawMappedFile)
 	{
-		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadTrajectoryIdsFromDisk: Failed to open file: %s"), *SourceFilePath);
+		UE_LOG(LogTemp, Warning, TEXT("FSpatialHashTable::MapFile: Platform does not support mapping %s"), *Filename);
 		return false;
 	}
+	MappedFile = MakeShareable(RawMappedFile);
 
-	bool bSuccess = true;
+	int64 FileSize = MappedFile->GetFileSize();
+	if (FileSize < (int64)sizeof(FSpatialHashHeader))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: File too small for header: %s"), *Filename);
+		UnmapFile();
+		return false;
+	}
+
+	IMappedFileRegion* RawRegion = MappedFile->MapRegion(0, FileSize);
+	if (!RawRegion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: Failed to map region of %s"), *Filename);
+		UnmapFile();
+		return false;
+	}
+	MappedRegion = MakeShareable(RawRegion);
 
-	// Calculate offset to trajectory IDs array
-	// File layout: Header (64 bytes) + Entries (NumEntries * 16 bytes) + TrajectoryIds
-	int64 TrajectoryIdsOffset = sizeof(FSpatialHashHeader) + (Header.NumEntries * sizeof(FSpatialHashEntry));
-	int64 ReadOffset = TrajectoryIdsOffset + (StartIndex * sizeof(uint32));
+	const uint8* MappedData = MappedRegion->GetMappedPtr();
+	FMemory::Memcpy(&Header, MappedData, sizeof(FSpatialHashHeader));
 
-	// Seek to the correct position
-	if (!FileHandle->Seek(ReadOffset))
+	if (Header.Magic != 0x54534854)
 	{
-		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadTrajectoryIdsFromDisk: Failed to seek to offset %lld"), ReadOffset);
-		bSuccess = false;
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: Invalid magic number: 0x%08X"), Header.Magic);
+		UnmapFile();
+		return false;
+	}
+	if (!IsSupportedVersion(Header.Version))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: Unsupported version: %u"), Header.Version);
+		UnmapFile();
+		return false;
 	}
 
-	// Read the trajectory IDs
-	if (bSuccess)
+	if (Header.Version >= FSpatialHashHeader::VersionCompactEntries && Header.EntryGroupSize == 0)
 	{
-		OutTrajectoryIds.SetNum(Count);
-		if (!FileHandle->Read(reinterpret_cast<uint8*>(OutTrajectoryIds.GetData()), Count * sizeof(uint32)))
-		{
-			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::ReadTrajectoryIdsFromDisk: Failed to read %u trajectory IDs"), Count);
-			bSuccess = false;
-		}
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: Invalid entry group size in %s"), *Filename);
+		UnmapFile();
+		return false;
 	}
 
-	delete FileHandle;
+	// File layout: Header (64 bytes) + entry sections + TrajectoryIds (raw or compressed) + learned index
+	const bool bCompressed = Header.Version >= FSpatialHashHeader::VersionCompressedIds;
+	const bool bHasLearnedIndex = Header.Version >= FSpatialHashHeader::VersionCompactEntries && Header.LearnedIndexBytes > 0;
+	int64 EntriesOffset = sizeof(FSpatialHashHeader);
+	int64 TrajectoryIdsOffset = GetTrajectoryIdSectionOffset(Header);
+	int64 ExpectedSize = TrajectoryIdsOffset + (bCompressed
+		? (int64)Header.CompressedIdBytes
+		: (int64)Header.NumTrajectoryIds * sizeof(uint32))
+		+ (bHasLearnedIndex ? (int64)Header.LearnedIndexBytes : 0);
+	if (MappedRegion->GetMappedSize() < ExpectedSize)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: File %s is truncated (%lld bytes, expected %lld)"),
+			*Filename, MappedRegion->GetMappedSize(), ExpectedSize);
+		UnmapFile();
+		return false;
+	}
 
-	return bSuccess;
+	if (Header.Version >= FSpatialHashHeader::VersionCompactEntries)
+	{
+		// Keys start at 64 and the 4-byte sections follow 8-byte keys, so all views are aligned
+		const int64 CountsOffset = EntriesOffset + (int64)Header.NumEntries * sizeof(uint64);
+		const int64 GroupOffsetsOffset = CountsOffset + (int64)Header.NumEntries * sizeof(uint32);
+		MappedEntryKeys = TArrayView<const uint64>(
+			reinterpret_cast<const uint64*>(MappedData + EntriesOffset), Header.NumEntries);
+		MappedEntryCounts = TArrayView<const uint32>(
+			reinterpret_cast<const uint32*>(MappedData + CountsOffset), Header.NumEntries);
+		MappedEntryGroupOffsets = TArrayView<const uint32>(
+			reinterpret_cast<const uint32*>(MappedData + GroupOffsetsOffset), GetNumEntryGroups(Header.NumEntries, Header.EntryGroupSize) + 1);
+	}
+	else
+	{
+		// Legacy records are split into owned key and count arrays
+		SetEntriesFromRecords(TArrayView<const FSpatialHashEntry>(
+			reinterpret_cast<const FSpatialHashEntry*>(MappedData + EntriesOffset), Header.NumEntries));
+	}
+
+	if (bCompressed)
+	{
+		MappedIdBlocks = TArrayView64<const uint8>(MappedData + TrajectoryIdsOffset, Header.CompressedIdBytes);
+	}
+	else
+	{
+		MappedTrajectoryIds = TArrayView<const uint32>(
+			reinterpret_cast<const uint32*>(MappedData + TrajectoryIdsOffset), Header.NumTrajectoryIds);
+	}
+
+	if (bHasLearnedIndex && !ReadLearnedIndex(MappedData + GetLearnedIndexOffset(Header), Header.LearnedIndexBytes))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTable::MapFile: Invalid learned index in %s"), *Filename);
+		UnmapFile();
+		return false;
+	}
+
+	return true;
+}
+
+void FSpatialHashTable::UnmapFile()
+{
+	MappedEntryKeys = TArrayView<const uint64>();
+	MappedEntryCounts = TArrayView<const uint32>();
+	MappedEntryGroupOffsets = TArrayView<const uint32>();
+	MappedTrajectoryIds = TArrayView<const uint32>();
+	MappedIdBlocks = TArrayView64<const uint8>();
+
+	// Indices over the mapped keys would dangle
+	ResetSearchIndex();
+	ResetHashIndex();
+	ResetLearnedIndex();
+
+	// Region must be released before the file handle
+	MappedRegion.Reset();
+	MappedFile.Reset();
 }
@@ -1,7 +1,9 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SpatialHashTableBuilder.h"
+#include "SpatialHashManifest.h"
 #include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
 #include "HAL/ThreadSafeBool.h"
 #include "Misc/Paths.h"
 #include "Async/ParallelFor.h"
@@ -16,10 +18,14 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 		return false;
 	}
 
-	if (Config.CellSize <= 0.0f)
+	const TArray<float> CellSizes = Config.GetCellSizes();
+	for (float CellSize : CellSizes)
 	{
-		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildHashTables: Invalid cell size: %f"), Config.CellSize);
-		return false;
+		if (CellSize <= 0.0f)
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildHashTables: Invalid cell size: %f"), CellSize);
+			return false;
+		}
 	}
 
 	// Compute or use provided bounding box
@@ -35,25 +41,36 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 	}
 
 	// Create directory structure
-	if (!CreateDirectoryStructure(Config.OutputDirectory, Config.CellSize))
+	for (float CellSize : CellSizes)
 	{
-		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildHashTables: Failed to create directory structure"));
-		return false;
+		if (!CreateDirectoryStructure(Config.OutputDirectory, CellSize))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildHashTables: Failed to create directory structure"));
+			return false;
+		}
 	}
 
 	// Build hash table for each time step
 	uint32 NumTimeSteps = FMath::Min((uint32)TimeStepSamples.Num(), Config.NumTimeSteps > 0 ? Config.NumTimeSteps : (uint32)TimeStepSamples.Num());
 	
-	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildHashTables: Building hash tables for %u time steps in parallel"), NumTimeSteps);
+	const int32 NumCellSizes = CellSizes.Num();
+	
+	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildHashTables: Building hash tables for %u time steps and %d cell sizes in parallel"),
+		NumTimeSteps, NumCellSizes);
 	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildHashTables: Config.StartTimeStep = %u"), Config.StartTimeStep);
 	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildHashTables: First file will be timestep_%05d.bin"), Config.StartTimeStep);
 
 	// Use thread-safe bool for error tracking
 	FThreadSafeBool bHasError(false);
 	FCriticalSection ErrorLogMutex;
+
+	// One manifest per cell size, filled under ManifestMutex as tables are saved
+	TArray<FSpatialHashManifest> Manifests;
+	Manifests.SetNum(NumCellSizes);
+	FCriticalSection ManifestMutex;
 	
-	// Process time steps in parallel
-	ParallelFor(NumTimeSteps, [&](int32 TimeStep)
+	// Process (time step, cell size) pairs in parallel; all cell sizes share the samples of a time step
+	ParallelFor(NumTimeSteps * NumCellSizes, [&](int32 TableIndex)
 	{
 		// Early exit if we've already encountered an error
 		if (bHasError)
@@ -61,10 +78,14 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 			return;
 		}
 		
+		const int32 TimeStep = TableIndex / NumCellSizes;
+		const float CellSize = CellSizes[TableIndex % NumCellSizes];
+		
 		FSpatialHashTable HashTable;
 		
 		// Create modified config with computed bounding box
 		FBuildConfig ModifiedConfig = Config;
+		ModifiedConfig.CellSize = CellSize;
 		ModifiedConfig.BBoxMin = BBoxMin;
 		ModifiedConfig.BBoxMax = BBoxMax;
 		ModifiedConfig.bComputeBoundingBox = false;
@@ -73,7 +94,7 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 		uint32 ActualTimeStep = Config.StartTimeStep + TimeStep;
 		
 		// Debug: Log first few timesteps
-		if (TimeStep < 3)
+		if (TimeStep < 3 && TableIndex % NumCellSizes == 0)
 		{
 			FScopeLock Lock(&ErrorLogMutex);
 			UE_LOG(LogTemp, Warning, TEXT("Building hash table: ArrayIndex=%d, Config.StartTimeStep=%u, ActualTimeStep=%u"),
@@ -89,8 +110,9 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 		}
 
 		// Save hash table to file using actual timestep number
-		FString Filename = GetOutputFilename(Config.OutputDirectory, Config.CellSize, ActualTimeStep);
-		if (!HashTable.SaveToFile(Filename))
+		FString Filename = GetOutputFilename(Config.OutputDirectory, CellSize, ActualTimeStep);
+		FSpatialHashManifest::FTable ManifestTable;
+		if (!HashTable.SaveToFile(Filename, &ManifestTable.Checksum, &ManifestTable.FileSize, Config.FileVersion))
 		{
 			FScopeLock Lock(&ErrorLogMutex);
 			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildHashTables: Failed to save hash table for time step %u"), ActualTimeStep);
@@ -98,13 +120,20 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 			return;
 		}
 
+		ManifestTable.SetFromHeader(HashTable.Header);
+		{
+			FScopeLock Lock(&ManifestMutex);
+			Manifests[TableIndex % NumCellSizes].AddTable(ManifestTable);
+		}
+
 		// MEMORY OPTIMIZATION: Free hash table memory immediately after saving to disk
 		// This is crucial for large datasets with millions of trajectories
-		HashTable.Entries.Empty();
+		HashTable.EntryKeys.Empty();
+		HashTable.EntryCounts.Empty();
 		HashTable.TrajectoryIds.Empty();
 
 		// Log progress at intervals (thread-safe logging)
-		if ((TimeStep + 1) % 100 == 0 || TimeStep == (int32)NumTimeSteps - 1)
+		if (TableIndex % NumCellSizes == 0 && ((TimeStep + 1) % 100 == 0 || TimeStep == (int32)NumTimeSteps - 1))
 		{
 			FScopeLock Lock(&ErrorLogMutex);
 			UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildHashTables: Processed %u / %u time steps"), TimeStep + 1, NumTimeSteps);
@@ -118,6 +147,18 @@ bool FSpatialHashTableBuilder::BuildHashTables(
 		return false;
 	}
 
+	for (int32 CellSizeIndex = 0; CellSizeIndex < NumCellSizes; ++CellSizeIndex)
+	{
+		FSpatialHashManifest& Manifest = Manifests[CellSizeIndex];
+		Manifest.CellSize = CellSizes[CellSizeIndex];
+		Manifest.Finalize();
+		if (!Manifest.SaveToFile(FSpatialHashManifest::GetManifestFilename(Config.OutputDirectory, Manifest.CellSize)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildHashTables: Failed to save manifest for cell size %.3f"), Manifest.CellSize);
+			return false;
+		}
+	}
+
 	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildHashTables: Successfully built and saved all hash tables"));
 	return true;
 }
@@ -137,8 +178,10 @@ bool FSpatialHashTableBuilder::BuildHashTableForTimeStep(
 	if (Samples.Num() == 0)
 	{
 		// Empty time step - valid but no data
-		OutHashTable.Header.NumEntries = 0;
-		OutHashTable.Header.NumTrajectoryIds = 0;
+		OutHashTable.EntryKeys.Reset();
+		OutHashTable.EntryCounts.Reset();
+		OutHashTable.TrajectoryIds.Reset();
+		OutHashTable.FinalizeEntries();
 		return true;
 	}
 
@@ -151,70 +194,339 @@ bool FSpatialHashTableBuilder::BuildHashTableForTimeStep(
 	// Key steps:
 	// 1. Partition 3D space into uniform grid cells
 	// 2. Map each cell to a Z-Order key (Morton code) for spatial locality
-	// 3. Collect all trajectory IDs in each cell
-	// 4. Sort by Z-Order keys for efficient binary search queries
+	// 3. Sort (key, trajectory ID) pairs by key with a stable radix sort
+	// 4. Emit one entry per run of equal keys in a single linear pass
+	//
+	// Working on one flat array avoids a heap allocation per cell. The sort is
+	// stable, so trajectory IDs keep their sample order within a cell.
 	// ============================================================================
 
-	// Map from Z-Order key to cell data
-	// This accumulates trajectory IDs for each spatial cell
-	TMap<uint64, TArray<uint32>> CellMap;
-
-	// STEP 1: Process each trajectory sample and assign to spatial cells
-	for (const FTrajectorySample& Sample : Samples)
+	// STEP 1 + 2: Compute the Z-Order key of every sample's cell
+	// Samples are transposed into small structure-of-arrays blocks so the
+	// conversions can run vectorized (see FSpatialHashTable batch functions)
+	TArray<FCellSample> CellSamples;
+	CellSamples.SetNumUninitialized(Samples.Num());
+	const FVector HeaderBBoxMin = OutHashTable.Header.GetBBoxMin();
+
+	constexpr int32 BlockSize = 256;
+	FVector::FReal BlockPosX[BlockSize];
+	FVector::FReal BlockPosY[BlockSize];
+	FVector::FReal BlockPosZ[BlockSize];
+	int32 BlockCellX[BlockSize];
+	int32 BlockCellY[BlockSize];
+	int32 BlockCellZ[BlockSize];
+	uint64 BlockKeys[BlockSize];
+
+	for (int32 BlockStart = 0; BlockStart < Samples.Num(); BlockStart += BlockSize)
 	{
-		// Convert 3D world position to discrete cell coordinates
-		int32 CellX, CellY, CellZ;
-		FSpatialHashTable::WorldToCellCoordinates(
-			Sample.Position,
-			Config.BBoxMin,
+		const int32 NumInBlock = FMath::Min(BlockSize, Samples.Num() - BlockStart);
+
+		for (int32 i = 0; i < NumInBlock; ++i)
+		{
+			const FVector& Position = Samples[BlockStart + i].Position;
+			BlockPosX[i] = Position.X;
+			BlockPosY[i] = Position.Y;
+			BlockPosZ[i] = Position.Z;
+		}
+
+		// Convert 3D world positions to discrete cell coordinates
+		// (with the box as stored in the header, which is what queries compute cells with)
+		FSpatialHashTable::WorldToCellCoordinatesBatch(
+			MakeArrayView(BlockPosX, NumInBlock),
+			MakeArrayView(BlockPosY, NumInBlock),
+			MakeArrayView(BlockPosZ, NumInBlock),
+			HeaderBBoxMin,
 			Config.CellSize,
-			CellX, CellY, CellZ);
+			BlockCellX, BlockCellY, BlockCellZ);
 
-		// STEP 2: Calculate Z-Order key (Morton code) for this cell
-		// This interleaves the bits of (x,y,z) to create a single 64-bit key
-		// that preserves spatial locality - nearby cells have similar keys
-		uint64 Key = FSpatialHashTable::CalculateZOrderKey(CellX, CellY, CellZ);
+		// Interleave the bits of (x,y,z) into a single 64-bit key that
+		// preserves spatial locality - nearby cells have similar keys
+		FSpatialHashTable::CalculateZOrderKeysBatch(
+			MakeArrayView(BlockCellX, NumInBlock),
+			MakeArrayView(BlockCellY, NumInBlock),
+			MakeArrayView(BlockCellZ, NumInBlock),
+			BlockKeys);
 
-		// STEP 3: Add trajectory ID to the corresponding cell
-		// Multiple trajectories can occupy the same cell
-		TArray<uint32>& TrajectoryIds = CellMap.FindOrAdd(Key);
-		TrajectoryIds.Add(Sample.TrajectoryId);
+		for (int32 i = 0; i < NumInBlock; ++i)
+		{
+			CellSamples[BlockStart + i].ZOrderKey = BlockKeys[i];
+			CellSamples[BlockStart + i].TrajectoryId = Samples[BlockStart + i].TrajectoryId;
+		}
 	}
 
-	// STEP 4: Convert cell map to hash table entries
-	OutHashTable.Entries.Reserve(CellMap.Num());
-	OutHashTable.TrajectoryIds.Reserve(Samples.Num());
-
-	// Sort Z-Order keys for consistent ordering and efficient binary search
-	TArray<uint64> Keys;
-	CellMap.GetKeys(Keys);
-	Keys.Sort();
+	// STEP 3: Sort by Z-Order key for efficient binary search
+	SortCellSamplesByKey(CellSamples);
 
-	// STEP 5: Build final hash table structure
-	// - Entries array: sorted by Z-Order key, each entry points to trajectory IDs
+	// STEP 4: Build final hash table structure
+	// - EntryKeys/EntryCounts arrays: sorted by Z-Order key, one key and ID count per cell
 	// - TrajectoryIds array: flat array of all trajectory IDs, grouped by cell
-	uint32 CurrentIndex = 0;
-	for (uint64 Key : Keys)
+	OutHashTable.EntryKeys.Reset();
+	OutHashTable.EntryCounts.Reset();
+	OutHashTable.TrajectoryIds.Reset(CellSamples.Num());
+
+	for (int32 SampleIdx = 0; SampleIdx < CellSamples.Num(); ++SampleIdx)
 	{
-		const TArray<uint32>& TrajectoryIds = CellMap[Key];
-		
-		// Create hash entry with Z-Order key and index into trajectory IDs array
-		FSpatialHashEntry Entry(Key, CurrentIndex, TrajectoryIds.Num());
-		OutHashTable.Entries.Add(Entry);
+		const FCellSample& CellSample = CellSamples[SampleIdx];
 
-		// Add trajectory IDs to flat array
-		for (uint32 TrajectoryId : TrajectoryIds)
+		// A new key starts a new cell
+		if (SampleIdx == 0 || CellSample.ZOrderKey != CellSamples[SampleIdx - 1].ZOrderKey)
 		{
-			OutHashTable.TrajectoryIds.Add(TrajectoryId);
+			OutHashTable.EntryKeys.Add(CellSample.ZOrderKey);
+			OutHashTable.EntryCounts.Add(0);
 		}
 
-		CurrentIndex += TrajectoryIds.Num();
+		++OutHashTable.EntryCounts.Last();
+		OutHashTable.TrajectoryIds.Add(CellSample.TrajectoryId);
+	}
+
+	// Sample the cell offsets and update header counts
+	OutHashTable.FinalizeEntries();
+
+	if (Config.LearnedIndexMaxError > 0)
+	{
+		OutHashTable.BuildLearnedIndex(Config.LearnedIndexMaxError);
 	}
 
-	// Update header counts
-	OutHashTable.Header.NumEntries = OutHashTable.Entries.Num();
-	OutHashTable.Header.NumTrajectoryIds = OutHashTable.TrajectoryIds.Num();
+	return true;
+}
+
+void FSpatialHashTableBuilder::SortCellSamplesByKey(TArray<FCellSample>& CellSamples)
+{
+	// LSD radix sort, 8 bits per pass over the 63-bit Z-Order key
+	constexpr int32 RadixBits = 8;
+	constexpr int32 NumBuckets = 1 << RadixBits;
+	constexpr int32 NumPasses = (63 + RadixBits - 1) / RadixBits;
+
+	const int32 NumSamples = CellSamples.Num();
+	if (NumSamples < 2)
+	{
+		return;
+	}
+
+	// Histograms of all passes in one read over the data
+	TArray<uint32> Histograms;
+	Histograms.SetNumZeroed(NumPasses * NumBuckets);
+	for (const FCellSample& CellSample : CellSamples)
+	{
+		for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+		{
+			++Histograms[Pass * NumBuckets + (int32)((CellSample.ZOrderKey >> (Pass * RadixBits)) & (NumBuckets - 1))];
+		}
+	}
+
+	TArray<FCellSample> Scratch;
+	Scratch.SetNumUninitialized(NumSamples);
+
+	FCellSample* Source = CellSamples.GetData();
+	FCellSample* Dest = Scratch.GetData();
+
+	for (int32 Pass = 0; Pass < NumPasses; ++Pass)
+	{
+		uint32* Histogram = Histograms.GetData() + Pass * NumBuckets;
+		const int32 Shift = Pass * RadixBits;
+
+		// All keys share this digit (typical for the high bits of small grids) - nothing to do
+		const uint32 FirstBucketCount = Histogram[(Source[0].ZOrderKey >> Shift) & (NumBuckets - 1)];
+		if (FirstBucketCount == (uint32)NumSamples)
+		{
+			continue;
+		}
+
+		// Bucket counts to start offsets
+		uint32 Offset = 0;
+		for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			const uint32 Count = Histogram[Bucket];
+			Histogram[Bucket] = Offset;
+			Offset += Count;
+		}
+
+		// Stable scatter
+		for (int32 SampleIdx = 0; SampleIdx < NumSamples; ++SampleIdx)
+		{
+			const FCellSample& CellSample = Source[SampleIdx];
+			Dest[Histogram[(CellSample.ZOrderKey >> Shift) & (NumBuckets - 1)]++] = CellSample;
+		}
+
+		Swap(Source, Dest);
+	}
+
+	// Result ended up in the scratch buffer after an odd number of passes
+	if (Source != CellSamples.GetData())
+	{
+		Swap(CellSamples, Scratch);
+	}
+}
+
+bool FSpatialHashTableBuilder::BuildCoarserLevel(
+	const FSpatialHashTable& FineTable,
+	int32 NumLevels,
+	FSpatialHashTable& OutCoarseTable,
+	uint32 LearnedIndexMaxError)
+{
+	if (NumLevels < 1 || NumLevels > MaxCoarserLevels)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevel: Invalid number of levels: %d"), NumLevels);
+		return false;
+	}
+
+	const uint32 KeyShift = 3 * NumLevels;
+	const TArrayView<const uint64> FineKeys = FineTable.GetEntryKeys();
+	const TArrayView<const uint32> FineCounts = FineTable.GetEntryCounts();
+
+	// Same time step and bounding box, so coarse cell coordinates are the fine ones shifted right
+	OutCoarseTable.Header = FineTable.Header;
+	OutCoarseTable.Header.CellSize = FineTable.Header.CellSize * (float)(1 << NumLevels);
+	OutCoarseTable.EntryKeys.Reset();
+	OutCoarseTable.EntryCounts.Reset();
+
+	for (int32 EntryIndex = 0; EntryIndex < FineKeys.Num(); ++EntryIndex)
+	{
+		// Fine entries are sorted by key and the shift keeps the order, so each coarse cell is one run
+		const uint64 CoarseKey = FineKeys[EntryIndex] >> KeyShift;
+		if (OutCoarseTable.EntryKeys.Num() == 0 || OutCoarseTable.EntryKeys.Last() != CoarseKey)
+		{
+			OutCoarseTable.EntryKeys.Add(CoarseKey);
+			OutCoarseTable.EntryCounts.Add(0);
+		}
+		OutCoarseTable.EntryCounts.Last() += FineCounts[EntryIndex];
+	}
+
+	// Each coarse cell concatenates a run of fine cells, so the coarse IDs are the fine IDs in order.
+	// A trajectory has one sample per time step and thus lies in exactly one fine cell,
+	// so this never produces duplicates.
+	if (!FineTable.GetTrajectoryIdsForEntryRange(0, FineKeys.Num(), OutCoarseTable.TrajectoryIds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevel: Failed to read trajectory IDs of %s"), *FineTable.SourceFilePath);
+		return false;
+	}
+
+	OutCoarseTable.FinalizeEntries();
+
+	// Coarser levels of a set saved with learned indices get one as well, with the same error bound
+	if (FineTable.HasLearnedIndex())
+	{
+		OutCoarseTable.BuildLearnedIndex(LearnedIndexMaxError > 0 ? LearnedIndexMaxError : FineTable.GetLearnedIndexMaxError());
+	}
+
+	return true;
+}
+
+bool FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles(
+	const FString& OutputDirectory,
+	float FineCellSize,
+	int32 NumLevels,
+	uint32 LearnedIndexMaxError)
+{
+	if (NumLevels < 1 || NumLevels > MaxCoarserLevels)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: Invalid number of levels: %d"), NumLevels);
+		return false;
+	}
+
+	const FString FineDirectory = FPaths::GetPath(GetOutputFilename(OutputDirectory, FineCellSize, 0));
+	TArray<FString> FineFiles;
+	IFileManager::Get().FindFiles(FineFiles, *FPaths::Combine(FineDirectory, TEXT("timestep_*.bin")), true, false);
+	FineFiles.Sort();
+
+	if (FineFiles.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: No hash tables found in %s"), *FineDirectory);
+		return false;
+	}
+
+	for (int32 Level = 1; Level <= NumLevels; ++Level)
+	{
+		if (!CreateDirectoryStructure(OutputDirectory, FineCellSize * (float)(1 << Level)))
+		{
+			return false;
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: Deriving %d coarser levels from %d tables with cell size %.3f"),
+		NumLevels, FineFiles.Num(), FineCellSize);
+
+	FThreadSafeBool bHasError(false);
+
+	// Each coarse table keeps the bounding box of its fine table
+	TArray<FSpatialHashManifest> Manifests;
+	Manifests.SetNum(NumLevels);
+	FCriticalSection ManifestMutex;
+
+	ParallelFor(FineFiles.Num(), [&](int32 FileIndex)
+	{
+		if (bHasError)
+		{
+			return;
+		}
+
+		// Memory-map the fine table so its trajectory IDs are resident without copying
+		FSpatialHashTable::FLoadOptions LoadOptions;
+		LoadOptions.bMemoryMap = true;
+
+		FSpatialHashTable FineTable;
+		const FString FineFile = FPaths::Combine(FineDirectory, FineFiles[FileIndex]);
+		if (!FineTable.LoadFromFile(FineFile, LoadOptions))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: Failed to load %s"), *FineFile);
+			bHasError = true;
+			return;
+		}
+
+		// Each level is derived from the previous one, which is already merged and resident
+		FSpatialHashTable Levels[2];
+		const FSpatialHashTable* Source = &FineTable;
+		for (int32 Level = 1; Level <= NumLevels; ++Level)
+		{
+			FSpatialHashTable& Coarse = Levels[Level & 1];
+			if (!BuildCoarserLevel(*Source, 1, Coarse, LearnedIndexMaxError))
+			{
+				bHasError = true;
+				return;
+			}
+
+			// Levels of a version 1 dataset stay readable by the same readers
+			const uint32 FileVersion = FineTable.Header.Version == FSpatialHashHeader::VersionRawIds
+				? FSpatialHashHeader::VersionRawIds : FSpatialHashHeader::VersionCompactEntries;
+			const FString CoarseFile = GetOutputFilename(OutputDirectory, Coarse.Header.CellSize, Coarse.Header.TimeStep);
+			FSpatialHashManifest::FTable ManifestTable;
+			if (!Coarse.SaveToFile(CoarseFile, &ManifestTable.Checksum, &ManifestTable.FileSize, FileVersion))
+			{
+				UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: Failed to save %s"), *CoarseFile);
+				bHasError = true;
+				return;
+			}
+
+			ManifestTable.SetFromHeader(Coarse.Header);
+			{
+				FScopeLock Lock(&ManifestMutex);
+				Manifests[Level - 1].AddTable(ManifestTable);
+			}
+
+			Source = &Coarse;
+		}
+	});
+
+	if (bHasError)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: One or more tables failed"));
+		return false;
+	}
+
+	for (int32 Level = 1; Level <= NumLevels; ++Level)
+	{
+		FSpatialHashManifest& Manifest = Manifests[Level - 1];
+		Manifest.CellSize = FineCellSize * (float)(1 << Level);
+		Manifest.Finalize();
+		if (!Manifest.SaveToFile(FSpatialHashManifest::GetManifestFilename(OutputDirectory, Manifest.CellSize)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: Failed to save manifest for cell size %.3f"),
+				Manifest.CellSize);
+			return false;
+		}
+	}
 
+	UE_LOG(LogTemp, Log, TEXT("FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles: Successfully derived all levels"));
 	return true;
 }
 
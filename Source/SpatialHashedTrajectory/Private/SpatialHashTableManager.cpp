@@ -1,15 +1,30 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SpatialHashTableManager.h"
+#include "SpatialHashFileHandlePool.h"
+#include "TrajectoryIdSet.h"
+#include "TrajectoryShardIndex.h"
+#include "SpatialHashManifest.h"
 #include "Misc/Paths.h"
 #include "HAL/PlatformFileManager.h"
+#include "HAL/FileManager.h"
 #include "Misc/FileHelper.h"
 #include "Async/Async.h"
 #include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Containers/Queue.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "TrajectoryDataLoader.h"
 #include "TrajectoryDataCppApi.h"
 
 USpatialHashTableManager::USpatialHashTableManager()
+	: bUseMemoryMappedTables(false)
+	, bUseTableSearchIndex(false)
+	, bUseTableHashIndex(false)
+	, LearnedIndexMaxError(0)
+	, ReadCoalesceGap(FSpatialHashTable::DefaultReadCoalesceGap)
 {
 }
 
@@ -36,6 +51,8 @@ int32 USpatialHashTableManager::LoadHashTables(
 		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::LoadHashTables: Hash tables not found for cell size %.3f. Attempting to create them..."),
 			CellSize);
 		
+		ReleaseHashTablesForRebuild(TArray<float>({ CellSize }));
+		
 		if (!TryCreateHashTables(DatasetDirectory, CellSize, StartTimeStep, EndTimeStep))
 		{
 			UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadHashTables: Failed to create hash tables"));
@@ -52,16 +69,52 @@ int32 USpatialHashTableManager::LoadHashTables(
 	}
 
 	// Now load the hash tables
+	// With a manifest, time steps without a table are skipped without touching the disk,
+	// and every loaded table must match the recorded file size, counts and bounding box
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	FSpatialHashManifest Manifest;
+	const bool bHasManifest = Manifest.LoadFromFile(FSpatialHashManifest::GetManifestFilename(DatasetDirectory, CellSize));
 	int32 LoadedCount = 0;
 
 	for (int32 TimeStep = StartTimeStep; TimeStep <= EndTimeStep; ++TimeStep)
 	{
+		const FSpatialHashManifest::FTable* ManifestTable = bHasManifest ? Manifest.FindTable(TimeStep) : nullptr;
+		if (bHasManifest && !ManifestTable)
+		{
+			continue;
+		}
+		
 		FString FilePath = FSpatialHashTableBuilder::GetOutputFilename(DatasetDirectory, CellSize, TimeStep);
 		
-		if (LoadHashTable(FilePath, CellSize, TimeStep))
+		if (ManifestTable && PlatformFile.FileSize(*FilePath) != ManifestTable->FileSize)
+		{
+			UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadHashTables: %s is missing or does not have the size recorded in the manifest"),
+				*FilePath);
+			continue;
+		}
+		
+		if (!LoadHashTable(FilePath, CellSize, TimeStep))
+		{
+			continue;
+		}
+		
+		if (ManifestTable)
 		{
-			LoadedCount++;
+			const TSharedPtr<FSpatialHashTable> HashTable = GetHashTable(CellSize, TimeStep);
+			if (HashTable->Header.NumEntries != ManifestTable->NumEntries ||
+				HashTable->Header.NumTrajectoryIds != ManifestTable->NumTrajectoryIds ||
+				HashTable->Header.GetBBoxMin() != ManifestTable->BBoxMin ||
+				HashTable->Header.GetBBoxMax() != ManifestTable->BBoxMax)
+			{
+				UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadHashTables: %s does not match the manifest (%u/%u entries, %u/%u IDs, or bounding box)"),
+					*FilePath, HashTable->Header.NumEntries, ManifestTable->NumEntries,
+					HashTable->Header.NumTrajectoryIds, ManifestTable->NumTrajectoryIds);
+				LoadedHashTables.Remove(FHashTableKey(CellSize, TimeStep));
+				continue;
+			}
 		}
+		
+		LoadedCount++;
 	}
 
 	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadHashTables: Loaded %d/%d hash tables for cell size %.3f"),
@@ -86,13 +139,19 @@ bool USpatialHashTableManager::LoadHashTable(const FString& FilePath, float Cell
 	TSharedPtr<FSpatialHashTable> HashTable = MakeShared<FSpatialHashTable>();
 
 	// Load from file
-	if (!HashTable->LoadFromFile(FilePath))
+	FSpatialHashTable::FLoadOptions LoadOptions;
+	LoadOptions.bMemoryMap = bUseMemoryMappedTables;
+	LoadOptions.bBuildSearchIndex = bUseTableSearchIndex;
+	if (!HashTable->LoadFromFile(FilePath, LoadOptions))
 	{
 		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::LoadHashTable: Failed to load hash table from %s"),
 			*FilePath);
 		return false;
 	}
 
+	HashTable->ReadCoalesceGap = ReadCoalesceGap;
+	HashTable->SetUseHashIndex(bUseTableHashIndex);
+
 	// Validate cell size matches
 	if (!FMath::IsNearlyEqual(HashTable->Header.CellSize, CellSize, CellSizeEpsilon))
 	{
@@ -141,6 +200,7 @@ bool USpatialHashTableManager::CreateHashTables(
 	Config.bComputeBoundingBox = ComputeBoundingBox;
 	Config.BoundingBoxMargin = BoundingBoxMargin;
 	Config.OutputDirectory = DatasetDirectory;
+	Config.LearnedIndexMaxError = LearnedIndexMaxError;
 
 	// In a real implementation, you would:
 	// 1. Get trajectory data from TrajectoryData plugin
@@ -178,64 +238,39 @@ int32 USpatialHashTableManager::QueryFixedRadiusNeighbors(
 		return 0;
 	}
 
-	// Calculate which cells to check based on radius
 	float RadiusSq = Radius * Radius;
-	int32 CellRadius = FMath::CeilToInt(Radius / CellSize);
 
-	// Get center cell coordinates
-	int32 CenterX, CenterY, CenterZ;
-	FSpatialHashTable::WorldToCellCoordinates(
-		QueryPosition,
-		HashTable->Header.GetBBoxMin(),
-		HashTable->Header.CellSize,
-		CenterX, CenterY, CenterZ);
+	// Query occupied cells that intersect the query sphere
+	TArray<int32> EntryIndices;
+	HashTable->FindEntriesInRadius(QueryPosition, Radius, EntryIndices);
 
-	// Query neighboring cells
 	TSet<uint32> FoundTrajectories;
 
-	for (int32 dx = -CellRadius; dx <= CellRadius; ++dx)
+	for (int32 EntryIndex : EntryIndices)
 	{
-		for (int32 dy = -CellRadius; dy <= CellRadius; ++dy)
+		// Get trajectory IDs for this cell
+		TArray<uint32> TrajectoryIds;
+		HashTable->GetTrajectoryIdsForCell(EntryIndex, TrajectoryIds);
+
+		// Check distance for each trajectory
+		for (uint32 TrajectoryId : TrajectoryIds)
 		{
-			for (int32 dz = -CellRadius; dz <= CellRadius; ++dz)
+			// Avoid duplicates if trajectory appears in multiple cells
+			if (FoundTrajectories.Contains(TrajectoryId))
 			{
-				int32 CellX = CenterX + dx;
-				int32 CellY = CenterY + dy;
-				int32 CellZ = CenterZ + dz;
-
-				// Calculate Z-Order key for this cell
-				uint64 Key = FSpatialHashTable::CalculateZOrderKey(CellX, CellY, CellZ);
-
-				// Find entry
-				int32 EntryIndex = HashTable->FindEntry(Key);
-				if (EntryIndex >= 0)
-				{
-					// Get trajectory IDs for this cell
-					TArray<uint32> TrajectoryIds;
-					HashTable->GetTrajectoryIdsForCell(EntryIndex, TrajectoryIds);
-
-					// Check distance for each trajectory
-					for (uint32 TrajectoryId : TrajectoryIds)
-					{
-						// Avoid duplicates if trajectory appears in multiple cells
-						if (FoundTrajectories.Contains(TrajectoryId))
-						{
-							continue;
-						}
+				continue;
+			}
 
-						// Get trajectory position at this time step
-						FVector TrajectoryPos = GetTrajectoryPosition(TrajectoryId, TimeStep);
+			// Get trajectory position at this time step
+			FVector TrajectoryPos = GetTrajectoryPosition(TrajectoryId, TimeStep);
 
-						// Calculate distance
-						float DistanceSq = FVector::DistSquared(QueryPosition, TrajectoryPos);
+			// Calculate distance
+			float DistanceSq = FVector::DistSquared(QueryPosition, TrajectoryPos);
 
-						if (DistanceSq <= RadiusSq)
-						{
-							FoundTrajectories.Add(TrajectoryId);
-							OutResults.Add(FSpatialQueryResult(TrajectoryId, FMath::Sqrt(DistanceSq)));
-						}
-					}
-				}
+			if (DistanceSq <= RadiusSq)
+			{
+				FoundTrajectories.Add(TrajectoryId);
+				OutResults.Add(FSpatialQueryResult(TrajectoryId, FMath::Sqrt(DistanceSq)));
 			}
 		}
 	}
@@ -291,8 +326,17 @@ void USpatialHashTableManager::UnloadHashTables(float CellSize)
 		}
 	}
 
+	FSpatialHashFileHandlePool& HandlePool = FSpatialHashFileHandlePool::Get();
 	for (const FHashTableKey& Key : KeysToRemove)
 	{
+		// Close the pooled file handle along with the table
+		if (const TSharedPtr<FSpatialHashTable>* HashTable = LoadedHashTables.Find(Key))
+		{
+			if (HashTable->IsValid())
+			{
+				HandlePool.Release((*HashTable)->SourceFilePath);
+			}
+		}
 		LoadedHashTables.Remove(Key);
 	}
 
@@ -303,6 +347,16 @@ void USpatialHashTableManager::UnloadHashTables(float CellSize)
 void USpatialHashTableManager::UnloadAllHashTables()
 {
 	int32 Count = LoadedHashTables.Num();
+
+	// Only close this manager's files - other managers may still read from the shared pool
+	FSpatialHashFileHandlePool& HandlePool = FSpatialHashFileHandlePool::Get();
+	for (const auto& Pair : LoadedHashTables)
+	{
+		if (Pair.Value.IsValid())
+		{
+			HandlePool.Release(Pair.Value->SourceFilePath);
+		}
+	}
 	LoadedHashTables.Reset();
 
 	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::UnloadAllHashTables: Unloaded %d hash tables"), Count);
@@ -352,9 +406,9 @@ void USpatialHashTableManager::GetMemoryStats(int32& OutTotalHashTables, int64&
 		const TSharedPtr<FSpatialHashTable>& HashTable = Pair.Value;
 		if (HashTable.IsValid())
 		{
-			// Approximate memory usage
+			// Approximate heap memory usage (memory-mapped tables live in the page cache and count as zero)
 			int64 HeaderSize = sizeof(FSpatialHashHeader);
-			int64 EntriesSize = HashTable->Entries.Num() * sizeof(FSpatialHashEntry);
+			int64 EntriesSize = HashTable->GetEntryMemoryBytes();
 			int64 IdsSize = HashTable->TrajectoryIds.Num() * sizeof(uint32);
 
 			OutTotalMemoryBytes += HeaderSize + EntriesSize + IdsSize;
@@ -362,6 +416,40 @@ void USpatialHashTableManager::GetMemoryStats(int32& OutTotalHashTables, int64&
 	}
 }
 
+void USpatialHashTableManager::SetMaxOpenFileHandles(int32 MaxOpenFiles)
+{
+	FSpatialHashFileHandlePool::Get().SetMaxOpenHandles(MaxOpenFiles);
+
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::SetMaxOpenFileHandles: Keeping at most %d hash table files open"),
+		FSpatialHashFileHandlePool::Get().GetMaxOpenHandles());
+}
+
+void USpatialHashTableManager::SetReadCoalesceGap(int32 GapInTrajectoryIds)
+{
+	ReadCoalesceGap = (uint32)FMath::Max(0, GapInTrajectoryIds);
+
+	for (const auto& Pair : LoadedHashTables)
+	{
+		if (Pair.Value.IsValid())
+		{
+			Pair.Value->ReadCoalesceGap = ReadCoalesceGap;
+		}
+	}
+}
+
+void USpatialHashTableManager::SetUseTableHashIndex(bool bEnable)
+{
+	bUseTableHashIndex = bEnable;
+
+	for (const auto& Pair : LoadedHashTables)
+	{
+		if (Pair.Value.IsValid())
+		{
+			Pair.Value->SetUseHashIndex(bUseTableHashIndex);
+		}
+	}
+}
+
 TSharedPtr<FSpatialHashTable> USpatialHashTableManager::GetHashTable(
 	float CellSize,
 	int32 TimeStep) const
@@ -394,7 +482,30 @@ bool USpatialHashTableManager::CheckHashTablesExist(
 {
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 	
-	// Check if ALL hash tables exist for this cell size
+	// With a manifest, every table of the range must be recorded. Files are not checked one by one
+	// (LoadHashTables compares each loaded table with its record); adding or deleting table files
+	// after the manifest was written updates the directory, so one stat catches a stale manifest.
+	FSpatialHashManifest Manifest;
+	const FString ManifestFilename = FSpatialHashManifest::GetManifestFilename(DatasetDirectory, CellSize);
+	if (Manifest.LoadFromFile(ManifestFilename))
+	{
+		if (!Manifest.HasAllTables(StartTimeStep, EndTimeStep))
+		{
+			return false;
+		}
+		
+		const FFileStatData DirectoryStat = PlatformFile.GetStatData(*FPaths::GetPath(ManifestFilename));
+		const FFileStatData ManifestStat = PlatformFile.GetStatData(*ManifestFilename);
+		if (!DirectoryStat.bIsValid || !ManifestStat.bIsValid || DirectoryStat.ModificationTime > ManifestStat.ModificationTime)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::CheckHashTablesExist: Table files changed after %s was written"),
+				*ManifestFilename);
+			return false;
+		}
+		return true;
+	}
+	
+	// Without a manifest, check if ALL hash tables exist for this cell size
 	int32 TotalExpected = EndTimeStep - StartTimeStep + 1;
 	int32 ExistingCount = 0;
 	
@@ -411,11 +522,28 @@ bool USpatialHashTableManager::CheckHashTablesExist(
 	return ExistingCount == TotalExpected;
 }
 
+// Format a list of cell sizes for logging, e.g. "5.000, 10.000"
+static FString FormatCellSizes(const TArray<float>& CellSizes)
+{
+	return FString::JoinBy(CellSizes, TEXT(", "), [](float CellSize) { return FString::Printf(TEXT("%.3f"), CellSize); });
+}
+
 bool USpatialHashTableManager::TryCreateHashTables(
 	const FString& DatasetDirectory,
 	float CellSize,
 	int32 StartTimeStep,
-	int32 EndTimeStep)
+	int32 EndTimeStep,
+	bool bForceRebuild)
+{
+	return TryCreateHashTables(DatasetDirectory, TArray<float>({ CellSize }), StartTimeStep, EndTimeStep, bForceRebuild);
+}
+
+bool USpatialHashTableManager::TryCreateHashTables(
+	const FString& DatasetDirectory,
+	const TArray<float>& CellSizes,
+	int32 StartTimeStep,
+	int32 EndTimeStep,
+	bool bForceRebuild)
 {
 	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 	
@@ -426,19 +554,57 @@ bool USpatialHashTableManager::TryCreateHashTables(
 		return false;
 	}
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::TryCreateHashTables: Creating hash tables for cell size %.3f from complete dataset (processing all shards)"),
-		CellSize);
+	if (CellSizes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::TryCreateHashTables: No cell sizes given"));
+		return false;
+	}
+	
+	// INCREMENTAL BUILD: cell sizes whose tables were built from shards only need the shards
+	// added or changed since. Cell sizes without tables, sets whose manifest does not record
+	// their shards, and forced rebuilds are built from all shards.
+	TArray<float> FullBuildCellSizes;
+	TArray<float> AppendCellSizes;
+	FBox PersistedBounds(ForceInit);
+	for (float CellSize : CellSizes)
+	{
+		FSpatialHashManifest Manifest;
+		if (bForceRebuild || !LoadOrCreateManifest(DatasetDirectory, CellSize, Manifest) || Manifest.GetShards().Num() == 0)
+		{
+			FullBuildCellSizes.Add(CellSize);
+			continue;
+		}
+		
+		AppendCellSizes.Add(CellSize);
+		PersistedBounds += FBox(Manifest.BBoxMin, Manifest.BBoxMax);
+	}
+	
+	if (AppendCellSizes.Num() > 0 && !AppendHashTablesForNewShards(DatasetDirectory, AppendCellSizes, PersistedBounds))
+	{
+		return false;
+	}
+	
+	if (FullBuildCellSizes.Num() == 0)
+	{
+		return true;
+	}
+	
+	const FString CellSizesStr = FormatCellSizes(FullBuildCellSizes);
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::TryCreateHashTables: Creating hash tables for cell size(s) %s from complete dataset (processing all shards)"),
+		*CellSizesStr);
 	
 	// MEMORY OPTIMIZATION: Build hash tables incrementally per batch
 	// Instead of loading all samples then building, we build after each batch
 	// This dramatically reduces peak memory usage
 	
-	// Setup configuration for building
+	// Setup configuration for building; all cell sizes share one pass over the shards
 	FSpatialHashTableBuilder::FBuildConfig Config;
-	Config.CellSize = CellSize;
+	Config.CellSize = FullBuildCellSizes[0];
+	Config.CellSizes = FullBuildCellSizes;
 	Config.bComputeBoundingBox = true;
 	Config.BoundingBoxMargin = 1.0f;
 	Config.OutputDirectory = DatasetDirectory;
+	Config.LearnedIndexMaxError = LearnedIndexMaxError;
 	
 	// Build hash tables incrementally during shard batch processing
 	if (!BuildHashTablesIncrementallyFromShards(DatasetDirectory, Config))
@@ -447,8 +613,156 @@ bool USpatialHashTableManager::TryCreateHashTables(
 		return false;
 	}
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::TryCreateHashTables: Successfully created hash tables for cell size %.3f"),
-		CellSize);
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::TryCreateHashTables: Successfully created hash tables for cell size(s) %s"),
+		*CellSizesStr);
+	
+	return true;
+}
+
+void USpatialHashTableManager::ReleaseHashTablesForRebuild(const TArray<float>& CellSizes)
+{
+	// Dropping the tables unmaps their files and closes their pooled handles
+	for (float CellSize : CellSizes)
+	{
+		UnloadHashTables(CellSize);
+	}
+}
+
+bool USpatialHashTableManager::LoadOrCreateManifest(
+	const FString& DatasetDirectory,
+	float CellSize,
+	FSpatialHashManifest& OutManifest) const
+{
+	const FString ManifestFilename = FSpatialHashManifest::GetManifestFilename(DatasetDirectory, CellSize);
+	if (OutManifest.LoadFromFile(ManifestFilename))
+	{
+		return true;
+	}
+	
+	// Table sets built before manifests existed get one from their table files (once)
+	if (!OutManifest.BuildFromTableFiles(DatasetDirectory, CellSize))
+	{
+		return false;
+	}
+	
+	if (!OutManifest.SaveToFile(ManifestFilename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadOrCreateManifest: Failed to save recreated manifest for cell size %.3f"),
+			CellSize);
+		return false;
+	}
+	return true;
+}
+
+bool USpatialHashTableManager::AppendHashTablesForNewShards(
+	const FString& DatasetDirectory,
+	const TArray<float>& CellSizes,
+	const FBox& PersistedBounds)
+{
+	TArray<FString> ShardFiles;
+	if (!GetShardFiles(DatasetDirectory, ShardFiles))
+	{
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::AppendHashTablesForNewShards: Failed to get shard files from %s"),
+			*DatasetDirectory);
+		return false;
+	}
+	
+	TArray<FSpatialHashManifest> Manifests;
+	Manifests.SetNum(CellSizes.Num());
+	for (int32 CellSizeIdx = 0; CellSizeIdx < CellSizes.Num(); ++CellSizeIdx)
+	{
+		if (!LoadOrCreateManifest(DatasetDirectory, CellSizes[CellSizeIdx], Manifests[CellSizeIdx]))
+		{
+			return false;
+		}
+	}
+	
+	// A shard needs building if any of the manifests has no record of it, or if its file
+	// has changed since (size or modification time differs from the record)
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	TArray<FString> ShardFilesToBuild;
+	TSet<FString> ShardNames;
+	TSet<FString> ShardNamesToBuild;
+	for (const FString& ShardFile : ShardFiles)
+	{
+		const FString ShardName = FPaths::GetCleanFilename(ShardFile);
+		const FFileStatData StatData = PlatformFile.GetStatData(*ShardFile);
+		ShardNames.Add(ShardName);
+		
+		for (const FSpatialHashManifest& Manifest : Manifests)
+		{
+			const FSpatialHashManifest::FShard* Shard = Manifest.FindShard(ShardName);
+			if (!Shard || Shard->FileSize != StatData.FileSize || Shard->TimeStamp != StatData.ModificationTime)
+			{
+				ShardFilesToBuild.Add(ShardFile);
+				ShardNamesToBuild.Add(ShardName);
+				break;
+			}
+		}
+	}
+	
+	// Tables of changed and deleted shards are removed before building: a changed shard may
+	// no longer cover all of its old time steps, and those tables would otherwise stay stale
+	for (FSpatialHashManifest& Manifest : Manifests)
+	{
+		bool bManifestChanged = false;
+		const TArray<FSpatialHashManifest::FShard> RecordedShards = Manifest.GetShards();
+		for (const FSpatialHashManifest::FShard& Shard : RecordedShards)
+		{
+			if (ShardNames.Contains(Shard.FileName) && !ShardNamesToBuild.Contains(Shard.FileName))
+			{
+				continue;
+			}
+			
+			const int32 ShardEndTimeStep = Shard.StartTimeStep + Shard.NumTimeSteps - 1;
+			for (int32 TimeStep = Shard.StartTimeStep; TimeStep <= ShardEndTimeStep; ++TimeStep)
+			{
+				IFileManager::Get().Delete(*FSpatialHashTableBuilder::GetOutputFilename(DatasetDirectory, Manifest.CellSize, TimeStep), false, false, true);
+			}
+			Manifest.RemoveTables(Shard.StartTimeStep, ShardEndTimeStep);
+			Manifest.RemoveShard(Shard.FileName);
+			bManifestChanged = true;
+		}
+		
+		if (bManifestChanged)
+		{
+			Manifest.Finalize();
+			if (!Manifest.SaveToFile(FSpatialHashManifest::GetManifestFilename(DatasetDirectory, Manifest.CellSize)))
+			{
+				UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::AppendHashTablesForNewShards: Failed to save manifest for cell size %.3f"),
+					Manifest.CellSize);
+				return false;
+			}
+		}
+	}
+	
+	const FString CellSizesStr = FormatCellSizes(CellSizes);
+	if (ShardFilesToBuild.Num() == 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::AppendHashTablesForNewShards: Hash tables for cell size(s) %s are up to date"),
+			*CellSizesStr);
+		return true;
+	}
+	
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::AppendHashTablesForNewShards: Building %d new or changed of %d shards for cell size(s) %s"),
+		ShardFilesToBuild.Num(), ShardFiles.Num(), *CellSizesStr);
+	
+	// The new tables get a running bound that starts at the existing tables' box and grows with
+	// the new samples, so no sample is ever clamped into a border cell. Each table records its own
+	// box, so the existing tables stay valid on their grids.
+	FSpatialHashTableBuilder::FBuildConfig Config;
+	Config.CellSize = CellSizes[0];
+	Config.CellSizes = CellSizes;
+	Config.bComputeBoundingBox = true;
+	Config.BoundingBoxMargin = 1.0f;
+	Config.OutputDirectory = DatasetDirectory;
+	Config.LearnedIndexMaxError = LearnedIndexMaxError;
+	
+	if (!BuildHashTablesIncrementallyFromShards(DatasetDirectory, Config, &ShardFilesToBuild, &PersistedBounds))
+	{
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::AppendHashTablesForNewShards: Failed to build hash tables"));
+		return false;
+	}
 	
 	return true;
 }
@@ -457,8 +771,25 @@ void USpatialHashTableManager::CreateHashTablesAsync(
 	const FString& DatasetDirectory,
 	float CellSize,
 	int32 StartTimeStep,
-	int32 EndTimeStep)
+	int32 EndTimeStep,
+	bool bForceRebuild)
+{
+	CreateHashTablesForCellSizesAsync(DatasetDirectory, TArray<float>({ CellSize }), StartTimeStep, EndTimeStep, bForceRebuild);
+}
+
+void USpatialHashTableManager::CreateHashTablesForCellSizesAsync(
+	const FString& DatasetDirectory,
+	const TArray<float>& CellSizes,
+	int32 StartTimeStep,
+	int32 EndTimeStep,
+	bool bForceRebuild)
 {
+	if (CellSizes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::CreateHashTablesAsync: No cell sizes given"));
+		return;
+	}
+	
 	// Use critical section to prevent race condition
 	FScopeLock Lock(&CreationMutex);
 	
@@ -470,11 +801,14 @@ void USpatialHashTableManager::CreateHashTablesAsync(
 
 	bIsCreatingHashTables = true;
 
+	// Loaded tables of these cell sizes are stale after the build and must not hold their files open
+	ReleaseHashTablesForRebuild(CellSizes);
+
 	// Use weak pointer to avoid use-after-free
 	TWeakObjectPtr<USpatialHashTableManager> WeakThis(this);
 
 	// Capture parameters by value for the async task
-	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, DatasetDirectory, CellSize, StartTimeStep, EndTimeStep]()
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, DatasetDirectory, CellSizes, StartTimeStep, EndTimeStep, bForceRebuild]()
 	{
 		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
 		
@@ -492,8 +826,8 @@ void USpatialHashTableManager::CreateHashTablesAsync(
 			return;
 		}
 		
-		UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateHashTablesAsync: Creating hash tables for cell size %.3f from complete dataset (processing all shards)"),
-			CellSize);
+		UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateHashTablesAsync: Creating hash tables for cell size(s) %s from complete dataset (processing all shards)"),
+			*FormatCellSizes(CellSizes));
 		
 		// MEMORY OPTIMIZATION: Build hash tables incrementally per batch
 		USpatialHashTableManager* Manager = WeakThis.Get();
@@ -502,25 +836,18 @@ void USpatialHashTableManager::CreateHashTablesAsync(
 			return;
 		}
 		
-		// Setup configuration for building
-		FSpatialHashTableBuilder::FBuildConfig Config;
-		Config.CellSize = CellSize;
-		Config.bComputeBoundingBox = true;
-		Config.BoundingBoxMargin = 1.0f;
-		Config.OutputDirectory = DatasetDirectory;
-		
-		// Build hash tables incrementally during shard batch processing
-		bool bSuccess = Manager->BuildHashTablesIncrementallyFromShards(DatasetDirectory, Config);
+		// Build hash tables incrementally during shard batch processing (only new or changed shards if tables exist)
+		bool bSuccess = Manager->TryCreateHashTables(DatasetDirectory, CellSizes, StartTimeStep, EndTimeStep, bForceRebuild);
 		
 		// Return to game thread for final logging, loading, and cleanup
-		AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess, CellSize, DatasetDirectory, StartTimeStep, EndTimeStep]()
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess, CellSizes, DatasetDirectory, StartTimeStep, EndTimeStep]()
 		{
 			if (USpatialHashTableManager* Mgr = WeakThis.Get())
 			{
 				if (bSuccess)
 				{
-					UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateHashTablesAsync: Successfully created hash tables for cell size %.3f"),
-						CellSize);
+					UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateHashTablesAsync: Successfully created hash tables for cell size(s) %s"),
+						*FormatCellSizes(CellSizes));
 					
 					// Load the newly created hash tables
 					// Note: Loading happens on game thread to safely update LoadedHashTables map.
@@ -529,7 +856,11 @@ void USpatialHashTableManager::CreateHashTablesAsync(
 					// For large datasets with hundreds of timesteps, consider calling LoadHashTables()
 					// separately in smaller batches if frame time is critical.
 					UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateHashTablesAsync: Loading newly created hash tables..."));
-					int32 LoadedCount = Mgr->LoadHashTables(DatasetDirectory, CellSize, StartTimeStep, EndTimeStep, false);
+					int32 LoadedCount = 0;
+					for (float CellSize : CellSizes)
+					{
+						LoadedCount += Mgr->LoadHashTables(DatasetDirectory, CellSize, StartTimeStep, EndTimeStep, false);
+					}
 					
 					if (LoadedCount > 0)
 					{
@@ -552,507 +883,794 @@ void USpatialHashTableManager::CreateHashTablesAsync(
 	});
 }
 
-bool USpatialHashTableManager::BuildHashTablesIncrementallyFromShards(
-	const FString& DatasetDirectory,
-	const FSpatialHashTableBuilder::FBuildConfig& BaseConfig)
+// Cell sizes of the coarser levels derived from a fine cell size (2x, 4x, ...)
+static TArray<float> GetCoarserCellSizes(float FineCellSize, int32 NumLevels)
 {
-	// BATCH PROCESSING WITH PER-TIMESTEP HASH TABLE BUILDING
-	// This method processes shards in batches. For each batch:
-	// 1. Load batch shards
-	// 2. Extract samples organized by timestep
-	// 3. Build hash table for each timestep in parallel
-	// 4. Write hash tables to disk
-	// 5. Free all batch data
-	// 
-	// Key insight: One shard contains multiple timesteps. Each timestep gets its own
-	// hash table file. Hash tables are independent and can be built in parallel.
-	// No accumulation across batches - each batch is self-contained.
-	
-	UTrajectoryDataLoader* Loader = UTrajectoryDataLoader::Get();
-	if (!Loader)
+	TArray<float> CellSizes;
+	for (int32 Level = 1; Level <= FMath::Min(NumLevels, FSpatialHashTableBuilder::MaxCoarserLevels); ++Level)
 	{
-		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::BuildHashTablesIncrementallyFromShards: Failed to get TrajectoryDataLoader"));
-		return false;
+		CellSizes.Add(FineCellSize * (float)(1 << Level));
 	}
+	return CellSizes;
+}
+
+void USpatialHashTableManager::CreateCoarserLevelsAsync(
+	const FString& DatasetDirectory,
+	float FineCellSize,
+	int32 StartTimeStep,
+	int32 EndTimeStep,
+	int32 NumLevels)
+{
+	// Use critical section to prevent race condition
+	FScopeLock Lock(&CreationMutex);
 	
-	// Use centralized shard file discovery
-	TArray<FString> ShardFiles;
-	if (!GetShardFiles(DatasetDirectory, ShardFiles))
+	if (bIsCreatingHashTables)
 	{
-		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::BuildHashTablesIncrementallyFromShards: Failed to get shard files from %s"),
-			*DatasetDirectory);
-		return false;
+		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::CreateCoarserLevelsAsync: Hash table creation already in progress"));
+		return;
 	}
-	
-	// PASS 1: Determine time range and bounding box
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::BuildHashTablesIncrementallyFromShards: Pass 1 - Scanning %d shards for time range and bounding box"),
-		ShardFiles.Num());
-	
-	int32 GlobalMinTimeStep = INT32_MAX;
-	int32 GlobalMaxTimeStep = INT32_MIN;
-	FVector BBoxMin(FLT_MAX, FLT_MAX, FLT_MAX);
-	FVector BBoxMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-	TArray<int32> ShardStartTimeSteps;
-	ShardStartTimeSteps.Reserve(ShardFiles.Num());
-	
-	for (const FString& ShardFile : ShardFiles)
+
+	bIsCreatingHashTables = true;
+
+	// Loaded tables of the coarser levels are replaced and must not hold their files open
+	const TArray<float> CoarseCellSizes = GetCoarserCellSizes(FineCellSize, NumLevels);
+	ReleaseHashTablesForRebuild(CoarseCellSizes);
+
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateCoarserLevelsAsync: Deriving %d levels from cell size %.3f"),
+		NumLevels, FineCellSize);
+
+	// Use weak pointer to avoid use-after-free
+	TWeakObjectPtr<USpatialHashTableManager> WeakThis(this);
+	const uint32 MaxError = LearnedIndexMaxError;
+
+	// Capture parameters by value for the async task
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [WeakThis, DatasetDirectory, FineCellSize, StartTimeStep, EndTimeStep, NumLevels, MaxError, CoarseCellSizes]()
 	{
-		// Use TrajectoryData plugin's LoadShardFile API
-		FShardFileData ShardData = Loader->LoadShardFile(ShardFile);
-		if (!ShardData.bSuccess)
-		{
-			UE_LOG(LogTemp, Warning, TEXT("BuildHashTablesIncrementallyFromShards: Failed to load shard %s: %s"),
-				*ShardFile, *ShardData.ErrorMessage);
-			continue;
-		}
+		const bool bSuccess = FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles(DatasetDirectory, FineCellSize, NumLevels, MaxError);
 		
-		int32 ShardStartTimeStep = ParseTimestepFromFilename(ShardFile);
-		int32 ShardEndTimeStep = ShardStartTimeStep + ShardData.Header.TimeStepIntervalSize - 1;
-		
-		GlobalMinTimeStep = FMath::Min(GlobalMinTimeStep, ShardStartTimeStep);
-		GlobalMaxTimeStep = FMath::Max(GlobalMaxTimeStep, ShardEndTimeStep);
-		ShardStartTimeSteps.Add(ShardStartTimeStep);
-		
-		// Compute bounding box if needed
-		if (BaseConfig.bComputeBoundingBox)
+		// Return to game thread for loading and cleanup
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, bSuccess, DatasetDirectory, StartTimeStep, EndTimeStep, CoarseCellSizes]()
 		{
-			for (const FShardTrajectoryEntry& Entry : ShardData.Entries)
+			if (USpatialHashTableManager* Manager = WeakThis.Get())
 			{
-				for (const FVector3f& Pos : Entry.Positions)
+				if (bSuccess)
 				{
-					if (!FMath::IsNaN(Pos.X) && !FMath::IsNaN(Pos.Y) && !FMath::IsNaN(Pos.Z))
+					int32 LoadedCount = 0;
+					for (float CellSize : CoarseCellSizes)
 					{
-						BBoxMin.X = FMath::Min(BBoxMin.X, (float)Pos.X);
-						BBoxMin.Y = FMath::Min(BBoxMin.Y, (float)Pos.Y);
-						BBoxMin.Z = FMath::Min(BBoxMin.Z, (float)Pos.Z);
-						BBoxMax.X = FMath::Max(BBoxMax.X, (float)Pos.X);
-						BBoxMax.Y = FMath::Max(BBoxMax.Y, (float)Pos.Y);
-						BBoxMax.Z = FMath::Max(BBoxMax.Z, (float)Pos.Z);
+						LoadedCount += Manager->LoadHashTables(DatasetDirectory, CellSize, StartTimeStep, EndTimeStep, false);
 					}
+					
+					UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateCoarserLevelsAsync: Created cell size(s) %s, loaded %d hash tables"),
+						*FormatCellSizes(CoarseCellSizes), LoadedCount);
 				}
+				else
+				{
+					UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::CreateCoarserLevelsAsync: Failed to derive coarser levels"));
+				}
+				
+				Manager->bIsCreatingHashTables = false;
 			}
-		}
-	}
+		});
+	});
+}
+
+bool USpatialHashTableManager::CreateCoarserLevels(
+	const FString& DatasetDirectory,
+	float FineCellSize,
+	int32 NumLevels)
+{
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::CreateCoarserLevels: Deriving %d levels from cell size %.3f"),
+		NumLevels, FineCellSize);
+	
+	ReleaseHashTablesForRebuild(GetCoarserCellSizes(FineCellSize, NumLevels));
 	
-	if (ShardStartTimeSteps.Num() == 0)
+	if (!FSpatialHashTableBuilder::BuildCoarserLevelsFromFiles(DatasetDirectory, FineCellSize, NumLevels, LearnedIndexMaxError))
 	{
-		UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to load any shard files"));
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::CreateCoarserLevels: Failed to derive coarser levels"));
 		return false;
 	}
 	
-	// Apply bounding box margin
-	if (BaseConfig.bComputeBoundingBox)
-	{
-		FVector Margin(BaseConfig.BoundingBoxMargin, BaseConfig.BoundingBoxMargin, BaseConfig.BoundingBoxMargin);
-		BBoxMin -= Margin;
-		BBoxMax += Margin;
-		
-		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Computed BBox: Min(%.2f,%.2f,%.2f) Max(%.2f,%.2f,%.2f)"),
-			BBoxMin.X, BBoxMin.Y, BBoxMin.Z, BBoxMax.X, BBoxMax.Y, BBoxMax.Z);
+	return true;
+}
+
+// Append all valid shard samples to per-timestep sample arrays (index = GlobalTimeStep - MinTimeStep)
+// Extraction is split into chunks of entries that first count their samples per timestep, then
+// scatter them into preallocated slots, so workers never share a write location and need no lock.
+// The resulting order is the same as a sequential pass (shard, entry, time step).
+// If OutBounds is given, it is extended by every extracted sample.
+static int32 ExtractSamplesByTimeStep(
+	TArrayView<const FShardFileData> ShardData,
+	TArrayView<const int32> ShardStartTimeSteps,
+	int32 MinTimeStep,
+	TArray<TArray<FSpatialHashTableBuilder::FTrajectorySample>>& InOutTimeStepSamples,
+	FBox* OutBounds = nullptr)
+{
+	struct FExtractionChunk
+	{
+		int32 ShardIdx;
+		int32 FirstEntry;
+		int32 EndEntry;
+		
+		// Time steps (array indices) the chunk's entries can reach, and where its counters start in ChunkCursors
+		int32 FirstArrayIndex;
+		int32 NumArrayIndices;
+		int64 FirstCursor;
+	};
+	
+	const int32 EntriesPerChunk = 1024;
+	const int32 NumTimeSteps = InOutTimeStepSamples.Num();
+	
+	// Chunks only get counters for the time steps their shard covers, so the cursor table grows
+	// with the shard sizes instead of chunks x all time steps
+	TArray<FExtractionChunk> Chunks;
+	int64 NumCursors = 0;
+	for (int32 ShardIdx = 0; ShardIdx < ShardData.Num(); ++ShardIdx)
+	{
+		const TArray<FShardTrajectoryEntry>& Entries = ShardData[ShardIdx].Entries;
+		const int32 ShardArrayIndex = ShardStartTimeSteps[ShardIdx] - MinTimeStep;
+		for (int32 FirstEntry = 0; FirstEntry < Entries.Num(); FirstEntry += EntriesPerChunk)
+		{
+			const int32 EndEntry = FMath::Min(FirstEntry + EntriesPerChunk, Entries.Num());
+			
+			int32 MaxPositions = 0;
+			for (int32 EntryIdx = FirstEntry; EntryIdx < EndEntry; ++EntryIdx)
+			{
+				MaxPositions = FMath::Max(MaxPositions, Entries[EntryIdx].Positions.Num());
+			}
+			
+			const int32 FirstArrayIndex = FMath::Max(ShardArrayIndex, 0);
+			const int32 EndArrayIndex = (int32)FMath::Min<int64>((int64)ShardArrayIndex + MaxPositions, NumTimeSteps);
+			if (EndArrayIndex <= FirstArrayIndex)
+			{
+				continue; // Nothing of this chunk lands in the output range
+			}
+			
+			Chunks.Add({ShardIdx, FirstEntry, EndEntry, FirstArrayIndex, EndArrayIndex - FirstArrayIndex, NumCursors});
+			NumCursors += EndArrayIndex - FirstArrayIndex;
+		}
 	}
-	else
+	
+	if (Chunks.Num() == 0 || NumTimeSteps == 0)
 	{
-		BBoxMin = BaseConfig.BBoxMin;
-		BBoxMax = BaseConfig.BBoxMax;
+		return 0;
 	}
 	
-	int32 TotalTimeSteps = GlobalMaxTimeStep - GlobalMinTimeStep + 1;
-	
-	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Time range: %d to %d (%d steps)"),
-		GlobalMinTimeStep, GlobalMaxTimeStep, TotalTimeSteps);
-	
-	// Create directory structure
-	if (!FSpatialHashTableBuilder::CreateDirectoryStructure(BaseConfig.OutputDirectory, BaseConfig.CellSize))
+	// Call Func(ArrayIndex, TrajectoryId, Position) for every valid sample of a chunk inside the output range
+	auto ForEachSampleInChunk = [&](const FExtractionChunk& Chunk, auto&& Func)
 	{
-		UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to create directory structure"));
-		return false;
-	}
+		const TArray<FShardTrajectoryEntry>& Entries = ShardData[Chunk.ShardIdx].Entries;
+		const int32 ShardStartTimeStep = ShardStartTimeSteps[Chunk.ShardIdx];
+		
+		for (int32 EntryIdx = Chunk.FirstEntry; EntryIdx < Chunk.EndEntry; ++EntryIdx)
+		{
+			const FShardTrajectoryEntry& Entry = Entries[EntryIdx];
+			if (Entry.ValidSampleCount == 0) continue;
+			
+			for (int32 LocalTimeStep = 0; LocalTimeStep < Entry.Positions.Num(); ++LocalTimeStep)
+			{
+				const FVector3f& Pos = Entry.Positions[LocalTimeStep];
+				if (FMath::IsNaN(Pos.X) || FMath::IsNaN(Pos.Y) || FMath::IsNaN(Pos.Z))
+					continue;
+				
+				int32 ArrayIndex = ShardStartTimeStep + LocalTimeStep - MinTimeStep;
+				if (ArrayIndex >= 0 && ArrayIndex < NumTimeSteps)
+				{
+					Func(ArrayIndex, static_cast<uint32>(Entry.TrajectoryId), Pos);
+				}
+			}
+		}
+	};
 	
-	// Initialize time step samples - one per timestep in THIS batch only
-	// We'll determine the timestep range from the current batch
-	int32 BatchMinTimeStep = INT32_MAX;
-	int32 BatchMaxTimeStep = INT32_MIN;
+	// Phase 1: count samples per chunk and timestep (and bound them if requested)
+	TArray64<int32> ChunkCursors;
+	ChunkCursors.SetNumZeroed(NumCursors);
 	
-	// PASS 2: Process shards in batches
-	// For each batch: load shards → build hash tables → write → free
-	const int32 BatchSize = 3;
-	int32 TotalShards = ShardFiles.Num();
+	TArray<FBox3f> ChunkBounds;
+	ChunkBounds.Init(FBox3f(ForceInit), OutBounds ? Chunks.Num() : 0);
 	
-	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Pass 2 - Processing %d shards in batches of %d"),
-		TotalShards, BatchSize);
+	ParallelFor(Chunks.Num(), [&](int32 ChunkIdx)
+	{
+		const FExtractionChunk& Chunk = Chunks[ChunkIdx];
+		int32* Counts = ChunkCursors.GetData() + Chunk.FirstCursor;
+		const int32 FirstArrayIndex = Chunk.FirstArrayIndex;
+		if (OutBounds)
+		{
+			FBox3f& Bounds = ChunkBounds[ChunkIdx];
+			ForEachSampleInChunk(Chunk, [Counts, FirstArrayIndex, &Bounds](int32 ArrayIndex, uint32, const FVector3f& Pos)
+			{
+				++Counts[ArrayIndex - FirstArrayIndex];
+				Bounds += Pos;
+			});
+		}
+		else
+		{
+			ForEachSampleInChunk(Chunk, [Counts, FirstArrayIndex](int32 ArrayIndex, uint32, const FVector3f&)
+			{
+				++Counts[ArrayIndex - FirstArrayIndex];
+			});
+		}
+	});
 	
-	for (int32 BatchStart = 0; BatchStart < TotalShards; BatchStart += BatchSize)
+	if (OutBounds)
 	{
-		int32 BatchEnd = FMath::Min(BatchStart + BatchSize, TotalShards);
-		int32 CurrentBatchSize = BatchEnd - BatchStart;
-		
-		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Processing batch %d-%d (%d shards)"),
-			BatchStart, BatchEnd - 1, CurrentBatchSize);
-		
-		// Determine timestep range for this batch
-		BatchMinTimeStep = INT32_MAX;
-		BatchMaxTimeStep = INT32_MIN;
-		
-		// Load current batch of shards
-		TArray<FShardFileData> BatchShardData;
-		BatchShardData.Reserve(CurrentBatchSize);
-		
-		for (int32 ShardIdx = BatchStart; ShardIdx < BatchEnd; ++ShardIdx)
+		for (const FBox3f& Bounds : ChunkBounds)
 		{
-			FShardFileData ShardData = Loader->LoadShardFile(ShardFiles[ShardIdx]);
-			if (ShardData.bSuccess)
+			if (Bounds.IsValid)
 			{
-				int32 ShardStartTimeStep = ShardStartTimeSteps[ShardIdx];
-				int32 ShardEndTimeStep = ShardStartTimeStep + ShardData.Header.TimeStepIntervalSize - 1;
-				BatchMinTimeStep = FMath::Min(BatchMinTimeStep, ShardStartTimeStep);
-				BatchMaxTimeStep = FMath::Max(BatchMaxTimeStep, ShardEndTimeStep);
-				BatchShardData.Add(MoveTemp(ShardData));
+				*OutBounds += FBox(Bounds);
 			}
 		}
-		
-		if (BatchShardData.Num() == 0)
+	}
+	
+	// Phase 2: turn counts into write offsets, visiting chunks in order so every timestep keeps
+	// the sequential sample order, then grow every timestep array once
+	TArray<int32> TimeStepEnds;
+	TimeStepEnds.SetNumUninitialized(NumTimeSteps);
+	for (int32 TimeStepIdx = 0; TimeStepIdx < NumTimeSteps; ++TimeStepIdx)
+	{
+		TimeStepEnds[TimeStepIdx] = InOutTimeStepSamples[TimeStepIdx].Num();
+	}
+	
+	for (const FExtractionChunk& Chunk : Chunks)
+	{
+		int32* Cursors = ChunkCursors.GetData() + Chunk.FirstCursor;
+		for (int32 Index = 0; Index < Chunk.NumArrayIndices; ++Index)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("BuildHashTablesIncrementallyFromShards: No valid shards in batch %d-%d"),
-				BatchStart, BatchEnd - 1);
-			continue;
+			int32& End = TimeStepEnds[Chunk.FirstArrayIndex + Index];
+			const int32 Count = Cursors[Index];
+			Cursors[Index] = End;
+			End += Count;
 		}
-		
-		int32 BatchTimeSteps = BatchMaxTimeStep - BatchMinTimeStep + 1;
-		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Batch timestep range: %d to %d (%d timesteps)"),
-			BatchMinTimeStep, BatchMaxTimeStep, BatchTimeSteps);
-		
-		// Extract samples from batch, organized by timestep
-		TArray<TArray<FSpatialHashTableBuilder::FTrajectorySample>> BatchTimeStepSamples;
-		BatchTimeStepSamples.SetNum(BatchTimeSteps);
-		
-		FCriticalSection SamplesMutex;
-		FThreadSafeCounter BatchSamplesProcessed;
-		
-		// Extract samples from all shards in this batch
-		ParallelFor(BatchShardData.Num(), [&](int32 BatchIdx)
+	}
+	
+	int32 NumExtracted = 0;
+	for (int32 TimeStepIdx = 0; TimeStepIdx < NumTimeSteps; ++TimeStepIdx)
+	{
+		TArray<FSpatialHashTableBuilder::FTrajectorySample>& Samples = InOutTimeStepSamples[TimeStepIdx];
+		NumExtracted += TimeStepEnds[TimeStepIdx] - Samples.Num();
+		Samples.SetNumUninitialized(TimeStepEnds[TimeStepIdx], EAllowShrinking::No);
+	}
+	
+	// Phase 3: scatter, every chunk writes only to its own slots
+	ParallelFor(Chunks.Num(), [&](int32 ChunkIdx)
+	{
+		const FExtractionChunk& Chunk = Chunks[ChunkIdx];
+		int32* Cursors = ChunkCursors.GetData() + Chunk.FirstCursor;
+		const int32 FirstArrayIndex = Chunk.FirstArrayIndex;
+		ForEachSampleInChunk(Chunk, [Cursors, FirstArrayIndex, &InOutTimeStepSamples](int32 ArrayIndex, uint32 TrajectoryId, const FVector3f& Pos)
+		{
+			FSpatialHashTableBuilder::FTrajectorySample& Sample = InOutTimeStepSamples[ArrayIndex].GetData()[Cursors[ArrayIndex - FirstArrayIndex]++];
+			Sample.TrajectoryId = TrajectoryId;
+			Sample.Position = FVector(Pos.X, Pos.Y, Pos.Z);
+		});
+	});
+	
+	return NumExtracted;
+}
+
+// Byte budget shared by the stages of the streaming hash table build.
+// Only the shard reader waits for budget. Later stages always get theirs, so the
+// pipeline cannot deadlock, and while they hold it the reader stops reading ahead.
+class FBuildMemoryBudget
+{
+public:
+	explicit FBuildMemoryBudget(int64 InLimitBytes)
+		: LimitBytes(FMath::Max<int64>(InLimitBytes, 1))
+		, UsedBytes(0)
+		, PeakBytes(0)
+		, bCancelled(false)
+		, ReleasedEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	{
+	}
+	
+	~FBuildMemoryBudget()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(ReleasedEvent);
+	}
+	
+	// Block until Bytes fit into the budget (always granted when nothing is held). Returns false if cancelled.
+	bool WaitAndAcquire(int64 Bytes)
+	{
+		for (;;)
 		{
-			const FShardFileData& ShardData = BatchShardData[BatchIdx];
-			int32 ShardStartTimeStep = ShardStartTimeSteps[BatchStart + BatchIdx];
-			
-			for (const FShardTrajectoryEntry& Entry : ShardData.Entries)
 			{
-				if (Entry.ValidSampleCount == 0) continue;
-				
-				for (int32 LocalTimeStep = 0; LocalTimeStep < Entry.Positions.Num(); ++LocalTimeStep)
+				FScopeLock Lock(&Mutex);
+				if (bCancelled)
 				{
-					const FVector3f& Pos = Entry.Positions[LocalTimeStep];
-					if (FMath::IsNaN(Pos.X) || FMath::IsNaN(Pos.Y) || FMath::IsNaN(Pos.Z))
-						continue;
-					
-					int32 GlobalTimeStep = ShardStartTimeStep + LocalTimeStep;
-					int32 ArrayIndex = GlobalTimeStep - BatchMinTimeStep;
-					
-					if (ArrayIndex >= 0 && ArrayIndex < BatchTimeStepSamples.Num())
-					{
-						FVector Position(Pos.X, Pos.Y, Pos.Z);
-						FSpatialHashTableBuilder::FTrajectorySample Sample(static_cast<uint32>(Entry.TrajectoryId), Position);
-						
-						FScopeLock Lock(&SamplesMutex);
-						BatchTimeStepSamples[ArrayIndex].Add(Sample);
-						BatchSamplesProcessed.Increment();
-					}
+					return false;
+				}
+				if (UsedBytes == 0 || UsedBytes + Bytes <= LimitBytes)
+				{
+					UsedBytes += Bytes;
+					PeakBytes = FMath::Max(PeakBytes, UsedBytes);
+					return true;
 				}
 			}
-		});
-		
-		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Batch %d-%d extracted %d samples"),
-			BatchStart, BatchEnd - 1, BatchSamplesProcessed.GetValue());
-		
-		// CRITICAL: Free batch shard data immediately after extraction
-		BatchShardData.Empty();
-		
-		// Build hash tables for each timestep in this batch (in parallel)
-		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Building %d hash tables in parallel"),
-			BatchTimeSteps);
-		
-		FThreadSafeBool bBuildError(false);
-		FCriticalSection ErrorLogMutex;
-		
-		ParallelFor(BatchTimeSteps, [&](int32 TimeStepIdx)
+			ReleasedEvent->Wait(100);
+		}
+	}
+	
+	// Take budget without waiting (may exceed the limit)
+	void Acquire(int64 Bytes)
+	{
+		FScopeLock Lock(&Mutex);
+		UsedBytes += Bytes;
+		PeakBytes = FMath::Max(PeakBytes, UsedBytes);
+	}
+	
+	void Release(int64 Bytes)
+	{
 		{
-			if (bBuildError) return;
-			
-			int32 GlobalTimeStep = BatchMinTimeStep + TimeStepIdx;
-			const TArray<FSpatialHashTableBuilder::FTrajectorySample>& Samples = BatchTimeStepSamples[TimeStepIdx];
-			
-			// Skip empty timesteps (log for debugging)
-			if (Samples.Num() == 0)
-			{
-				UE_LOG(LogTemp, Verbose, TEXT("BuildHashTablesIncrementallyFromShards: Timestep %d has no samples, skipping"),
-					GlobalTimeStep);
-				return;
-			}
-			
-			// Build hash table for this single timestep
-			FSpatialHashTable HashTable;
-			
-			FSpatialHashTableBuilder::FBuildConfig TimeStepConfig = BaseConfig;
-			TimeStepConfig.BBoxMin = BBoxMin;
-			TimeStepConfig.BBoxMax = BBoxMax;
-			TimeStepConfig.bComputeBoundingBox = false;
-			
-			FSpatialHashTableBuilder Builder;
-			if (!Builder.BuildHashTableForTimeStep(GlobalTimeStep, Samples, TimeStepConfig, HashTable))
-			{
-				FScopeLock Lock(&ErrorLogMutex);
-				UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to build hash table for timestep %d"),
-					GlobalTimeStep);
-				bBuildError = true;
-				return;
-			}
-			
-			// Write hash table to disk immediately
-			FString Filename = FSpatialHashTableBuilder::GetOutputFilename(BaseConfig.OutputDirectory, BaseConfig.CellSize, GlobalTimeStep);
-			if (!HashTable.SaveToFile(Filename))
-			{
-				FScopeLock Lock(&ErrorLogMutex);
-				UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to save hash table for timestep %d"),
-					GlobalTimeStep);
-				bBuildError = true;
-				return;
-			}
-		});
-		
-		if (bBuildError)
+			FScopeLock Lock(&Mutex);
+			UsedBytes -= Bytes;
+		}
+		ReleasedEvent->Trigger();
+	}
+	
+	// Wake up and fail all current and future waiters
+	void Cancel()
+	{
 		{
-			UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to build hash tables for batch %d-%d"),
-				BatchStart, BatchEnd - 1);
-			return false;
+			FScopeLock Lock(&Mutex);
+			bCancelled = true;
 		}
-		
-		// CRITICAL: Free all batch timestep samples before loading next batch
-		BatchTimeStepSamples.Empty();
-		
-		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Batch %d-%d complete, %d hash tables built and saved, all data freed"),
-			BatchStart, BatchEnd - 1, BatchTimeSteps);
+		ReleasedEvent->Trigger();
 	}
 	
-	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Successfully completed incremental hash table building"));
-	return true;
-}
+	// Highest number of bytes held at once
+	int64 GetPeakBytes()
+	{
+		FScopeLock Lock(&Mutex);
+		return PeakBytes;
+	}
+	
+	int64 GetLimitBytes() const { return LimitBytes; }
+	
+private:
+	const int64 LimitBytes;
+	int64 UsedBytes;
+	int64 PeakBytes;
+	bool bCancelled;
+	FCriticalSection Mutex;
+	FEvent* ReleasedEvent;
+};
 
-bool USpatialHashTableManager::LoadTrajectoryDataFromDirectory(
+bool USpatialHashTableManager::BuildHashTablesIncrementallyFromShards(
 	const FString& DatasetDirectory,
-	int32 StartTimeStep,
-	int32 EndTimeStep,
-	TArray<TArray<FSpatialHashTableBuilder::FTrajectorySample>>& OutTimeStepSamples,
-	int32& OutGlobalMinTimeStep)
+	const FSpatialHashTableBuilder::FBuildConfig& BaseConfig,
+	const TArray<FString>* ShardFilesToBuild,
+	const FBox* InitialBounds)
 {
-	OutTimeStepSamples.Reset();
-	OutGlobalMinTimeStep = 0;
+	// STREAMING PIPELINE WITH PER-TIMESTEP HASH TABLE BUILDING
+	// Every shard is read exactly once. Pass 1 only parses file names; pass 2 runs
+	// as a pipeline whose stages overlap:
+	// 1. Read: a reader thread loads shards ahead of the build
+	// 2. Bucket: samples of a shard are extracted per timestep in parallel
+	// 3. Build: one hash table per timestep of the shard, in parallel
+	// 4. Write: a thread pool task saves the tables while the next shard is processed
+	// 
+	// Key insight: One shard contains multiple timesteps. Each timestep gets its own
+	// hash table file. Hash tables are independent and can be built in parallel.
+	// Read-ahead is bounded by BaseConfig.MemoryBudgetBytes: the reader waits while
+	// loaded shards, samples and unwritten tables use up the budget.
 	
-	// Use the trajectory data plugin to load shards
 	UTrajectoryDataLoader* Loader = UTrajectoryDataLoader::Get();
 	if (!Loader)
 	{
-		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Failed to get TrajectoryDataLoader. Please ensure the TrajectoryData plugin is properly installed and enabled."));
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::BuildHashTablesIncrementallyFromShards: Failed to get TrajectoryDataLoader"));
 		return false;
 	}
 	
-	// Use centralized shard file discovery
+	// Always enumerate fresh here - the catalog built below replaces the cached one.
+	// The time stamp is taken first so a change during the build invalidates the catalog.
+	const FDateTime DirectoryTimeStamp = GetDirectoryTimeStamp(DatasetDirectory);
 	TArray<FString> ShardFiles;
-	if (!GetShardFiles(DatasetDirectory, ShardFiles))
+	if (ShardFilesToBuild)
+	{
+		ShardFiles = *ShardFilesToBuild;
+	}
+	else if (!GetShardFiles(DatasetDirectory, ShardFiles))
 	{
-		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Failed to get shard files from %s"),
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::BuildHashTablesIncrementallyFromShards: Failed to get shard files from %s"),
 			*DatasetDirectory);
 		return false;
 	}
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Found %d shard files"), ShardFiles.Num());
-	
-	// Determine the global time step range from the dataset
-	// We'll process all shards to build complete hash tables
-	int32 GlobalMinTimeStep = INT32_MAX;
-	int32 GlobalMaxTimeStep = INT32_MIN;
-	
-	// MEMORY OPTIMIZATION: First pass - lightweight scan to determine time range
-	// We need to know the time range before we can initialize OutTimeStepSamples,
-	// but we don't want to load all shard data at once.
-	// So we'll do a lightweight pass to get just the time range from each shard.
-	TArray<int32> ShardStartTimeSteps;
+	// PASS 1: Start time steps come from the file names - no shard is read here
+	TArray<int32> ShardStartTimeSteps; // Parallel to ShardFiles
 	ShardStartTimeSteps.Reserve(ShardFiles.Num());
+	for (const FString& ShardFile : ShardFiles)
+	{
+		ShardStartTimeSteps.Add(ParseTimestepFromFilename(ShardFile));
+	}
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: First pass - determining time range from %d shards"), ShardFiles.Num());
+	// All cell sizes are built from the same extracted samples
+	const TArray<float> CellSizes = BaseConfig.GetCellSizes();
+	const int32 NumCellSizes = CellSizes.Num();
 	
-	for (const FString& ShardFile : ShardFiles)
+	// Create directory structure
+	for (float CellSize : CellSizes)
 	{
-		// Use TrajectoryData plugin's LoadShardFile API to get the time range
-		FShardFileData ShardData = Loader->LoadShardFile(ShardFile);
-		if (!ShardData.bSuccess)
+		if (CellSize <= 0.0f)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Failed to load shard %s: %s"),
-				*ShardFile, *ShardData.ErrorMessage);
-			continue;
+			UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Invalid cell size: %f"), CellSize);
+			return false;
 		}
 		
-		// Parse the starting timestep from the shard filename
-		int32 ShardStartTimeStep = ParseTimestepFromFilename(ShardFile);
-		
-		// Calculate the time step range for this shard
-		int32 ShardEndTimeStep = ShardStartTimeStep + ShardData.Header.TimeStepIntervalSize - 1;
-		
-		UE_LOG(LogTemp, Verbose, TEXT("Shard %s: timestep=%d, size=%d, range: %d to %d"),
-			*FPaths::GetCleanFilename(ShardFile), ShardStartTimeStep, ShardData.Header.TimeStepIntervalSize,
-			ShardStartTimeStep, ShardEndTimeStep);
-		
-		GlobalMinTimeStep = FMath::Min(GlobalMinTimeStep, ShardStartTimeStep);
-		GlobalMaxTimeStep = FMath::Max(GlobalMaxTimeStep, ShardEndTimeStep);
-		
-		// Store starting timestep for second pass
-		ShardStartTimeSteps.Add(ShardStartTimeStep);
-		
-		// IMPORTANT: Shard data freed automatically when ShardData goes out of scope
-		// This prevents loading all shards into memory at once
+		if (!FSpatialHashTableBuilder::CreateDirectoryStructure(BaseConfig.OutputDirectory, CellSize))
+		{
+			UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to create directory structure"));
+			return false;
+		}
 	}
 	
-	if (ShardStartTimeSteps.Num() == 0)
+	// One manifest per cell size, written once all tables are. A partial build extends the
+	// existing manifests; a full build starts over and removes the old ones first, so an
+	// interrupted build never leaves a manifest describing other tables.
+	TArray<FSpatialHashManifest> Manifests;
+	Manifests.SetNum(NumCellSizes);
+	for (int32 CellSizeIdx = 0; CellSizeIdx < NumCellSizes; ++CellSizeIdx)
 	{
-		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Failed to load any shard files"));
-		return false;
+		const FString ManifestFilename = FSpatialHashManifest::GetManifestFilename(BaseConfig.OutputDirectory, CellSizes[CellSizeIdx]);
+		if (ShardFilesToBuild)
+		{
+			Manifests[CellSizeIdx].LoadFromFile(ManifestFilename);
+		}
+		else
+		{
+			IFileManager::Get().Delete(*ManifestFilename, false, false, true);
+		}
+		Manifests[CellSizeIdx].CellSize = CellSizes[CellSizeIdx];
 	}
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Global time step range: %d to %d"),
-		GlobalMinTimeStep, GlobalMaxTimeStep);
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: GlobalMinTimeStep = %d will be used as StartTimeStep"),
-		GlobalMinTimeStep);
+	// Every shard is decoded exactly once by the pipeline, so the per-trajectory shard
+	// index and the shard catalog used by queries are filled on the way
+	TSharedPtr<FTrajectoryShardIndex, ESPMode::ThreadSafe> ShardIndex = MakeShared<FTrajectoryShardIndex, ESPMode::ThreadSafe>();
+	TSharedPtr<FShardCatalog, ESPMode::ThreadSafe> Catalog = MakeShared<FShardCatalog, ESPMode::ThreadSafe>();
+	Catalog->ShardFiles = ShardFiles;
+	Catalog->DirectoryTimeStamp = DirectoryTimeStamp;
+	bool bShardIndexComplete = true;
+	bool bReaderCompleted = false;
 	
-	// Store the global minimum timestep for the caller
-	OutGlobalMinTimeStep = GlobalMinTimeStep;
+	// PASS 2: Stream shards through read -> bucket -> build -> write
+	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Streaming %d shards for %d cell size(s) (memory budget %lld MB)"),
+		ShardFiles.Num(), NumCellSizes, BaseConfig.MemoryBudgetBytes / (1024 * 1024));
 	
-	// Initialize output array for all time steps in the dataset
-	int32 TotalTimeSteps = GlobalMaxTimeStep - GlobalMinTimeStep + 1;
-	OutTimeStepSamples.SetNum(TotalTimeSteps);
+	struct FLoadedShard
+	{
+		FShardFileData Data;
+		int32 StartTimeStep = 0;
+		int64 BudgetBytes = 0;
+	};
 	
-	// MEMORY OPTIMIZATION: Second pass - process shards in batches
-	// Process 3 shards at a time (configurable) to prevent memory overflow
-	const int32 BatchSize = 3; // Configurable: 2-3 for memory-constrained systems, 5-10 for high-memory systems
-	int32 TotalShards = ShardFiles.Num();
-	int32 TotalSamplesProcessed = 0;
+	// Written by the reader, read after it has finished; added to the manifests with the tables
+	TArray<FSpatialHashManifest::FShard> ShardRecords;
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Processing %d shards in batches of %d"),
-		TotalShards, BatchSize);
+	FBuildMemoryBudget Budget(BaseConfig.MemoryBudgetBytes);
+	TQueue<TUniquePtr<FLoadedShard>, EQueueMode::Spsc> LoadedShards;
+	FEvent* ShardLoadedEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	FThreadSafeBool bReaderDone(false);
 	
-	FCriticalSection SamplesMutex;
+	// Stage 1: read-ahead on a dedicated I/O thread
+	TFuture<void> ReaderFuture = Async(EAsyncExecution::Thread, [&]()
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		
+		int32 ShardIdx = 0;
+		for (; ShardIdx < ShardFiles.Num(); ++ShardIdx)
+		{
+			// A decoded shard is about as large as its file. The stat is taken before reading, so a
+			// shard that changes while it is read never matches its manifest record.
+			const FFileStatData StatData = PlatformFile.GetStatData(*ShardFiles[ShardIdx]);
+			const int64 EstimatedBytes = FMath::Max<int64>(StatData.FileSize, 0);
+			if (!Budget.WaitAndAcquire(EstimatedBytes))
+			{
+				break;
+			}
+			
+			TUniquePtr<FLoadedShard> Loaded = MakeUnique<FLoadedShard>();
+			Loaded->Data = Loader->LoadShardFile(ShardFiles[ShardIdx]);
+			if (!Loaded->Data.bSuccess)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("BuildHashTablesIncrementallyFromShards: Failed to load shard %s: %s"),
+					*ShardFiles[ShardIdx], *Loaded->Data.ErrorMessage);
+				Budget.Release(EstimatedBytes);
+				bShardIndexComplete = false;
+				continue;
+			}
+			
+			ShardIndex->AddShard(ShardFiles[ShardIdx], ShardStartTimeSteps[ShardIdx], Loaded->Data);
+			
+			FShardInfo& Info = Catalog->Shards.AddDefaulted_GetRef();
+			Info.FilePath = ShardFiles[ShardIdx];
+			Info.StartTimeStep = ShardStartTimeSteps[ShardIdx];
+			Info.TimeStepIntervalSize = Loaded->Data.Header.TimeStepIntervalSize;
+			Info.NumTrajectories = Loaded->Data.Entries.Num();
+			
+			FSpatialHashManifest::FShard& ShardRecord = ShardRecords.AddDefaulted_GetRef();
+			ShardRecord.FileName = FPaths::GetCleanFilename(ShardFiles[ShardIdx]);
+			ShardRecord.StartTimeStep = ShardStartTimeSteps[ShardIdx];
+			ShardRecord.NumTimeSteps = FMath::Max(Loaded->Data.Header.TimeStepIntervalSize, 0);
+			ShardRecord.FileSize = StatData.FileSize;
+			ShardRecord.TimeStamp = StatData.ModificationTime;
+			
+			Loaded->StartTimeStep = ShardStartTimeSteps[ShardIdx];
+			Loaded->BudgetBytes = EstimatedBytes;
+			LoadedShards.Enqueue(MoveTemp(Loaded));
+			ShardLoadedEvent->Trigger();
+		}
+		
+		bReaderCompleted = ShardIdx == ShardFiles.Num();
+		bReaderDone = true;
+		ShardLoadedEvent->Trigger();
+	});
+	
+	// Without a configured bounding box, tables use a running bound over all samples seen so far,
+	// so tables of one set can sit on different grids. A table's header is the only authority on
+	// its grid: queries read it from there, and set-level code (manifests, incremental builds)
+	// must not assume that one box describes every table.
+	// Incremental builds start the running bound at the existing tables' box.
+	FBox RunningBounds = InitialBounds ? *InitialBounds : FBox(ForceInit);
+	const FVector Margin(BaseConfig.BoundingBoxMargin);
+	int32 GlobalMinTimeStep = INT32_MAX;
+	int32 GlobalMaxTimeStep = INT32_MIN;
+	
+	FSpatialHashTableBuilder::FBuildConfig TimeStepConfig = BaseConfig;
+	TimeStepConfig.bComputeBoundingBox = false;
+	TimeStepConfig.CellSizes.Reset(); // Each table is built with the single cell size set below
 	
-	// Process shards in batches
-	for (int32 BatchStart = 0; BatchStart < TotalShards; BatchStart += BatchSize)
+	TFuture<bool> PendingWrite;
+	bool bBuildError = false;
+	int32 NumShardsProcessed = 0;
+	
+	// Enough time steps per group to give every worker a few tables to build (one per cell size and time step)
+	const int32 TargetTimeStepsPerGroup = FMath::DivideAndRoundUp(2 * (FTaskGraphInterface::Get().GetNumWorkerThreads() + 1), NumCellSizes);
+	
+	while (!bBuildError)
 	{
-		int32 BatchEnd = FMath::Min(BatchStart + BatchSize, TotalShards);
-		int32 CurrentBatchSize = BatchEnd - BatchStart;
+		TUniquePtr<FLoadedShard> Loaded;
+		if (!LoadedShards.Dequeue(Loaded))
+		{
+			// The reader enqueues before it reports completion, so check the queue once more
+			if (bReaderDone)
+			{
+				if (!LoadedShards.Dequeue(Loaded))
+				{
+					break;
+				}
+			}
+			else
+			{
+				ShardLoadedEvent->Wait(100);
+				continue;
+			}
+		}
 		
-		UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Processing batch %d-%d (%d shards)"),
-			BatchStart, BatchEnd - 1, CurrentBatchSize);
+		// Adaptive batching: a shard with few time steps cannot keep every core busy in the
+		// build stage, so further shards that are already loaded join the group. Their memory
+		// is already accounted for, so grouping never exceeds the budget.
+		TArray<TUniquePtr<FLoadedShard>> Group;
+		int32 GroupTimeSteps = FMath::Max(Loaded->Data.Header.TimeStepIntervalSize, 0);
+		Group.Add(MoveTemp(Loaded));
+		while (GroupTimeSteps < TargetTimeStepsPerGroup && LoadedShards.Dequeue(Loaded))
+		{
+			GroupTimeSteps += FMath::Max(Loaded->Data.Header.TimeStepIntervalSize, 0);
+			Group.Add(MoveTemp(Loaded));
+		}
 		
-		// Load current batch of shards
-		TArray<FShardFileData> BatchShardData;
-		TArray<int32> BatchShardStartTimeSteps;
-		BatchShardData.Reserve(CurrentBatchSize);
-		BatchShardStartTimeSteps.Reserve(CurrentBatchSize);
+		// Stage 2: bucket each shard's samples by timestep (lock-free count-then-scatter)
+		TArray<TArray<FSpatialHashTableBuilder::FTrajectorySample>> TimeStepSamples;
+		TArray<int32> TimeSteps; // Parallel to TimeStepSamples
+		TimeStepSamples.Reserve(GroupTimeSteps);
+		TimeSteps.Reserve(GroupTimeSteps);
+		int32 NumSamples = 0;
+		int64 SampleBytes = 0;
 		
-		for (int32 ShardIdx = BatchStart; ShardIdx < BatchEnd; ++ShardIdx)
+		for (TUniquePtr<FLoadedShard>& Shard : Group)
 		{
-			const FString& ShardFile = ShardFiles[ShardIdx];
-			FShardFileData ShardData = Loader->LoadShardFile(ShardFile);
+			const int32 ShardStartTimeStep = Shard->StartTimeStep;
+			const int32 ShardTimeSteps = FMath::Max(Shard->Data.Header.TimeStepIntervalSize, 0);
 			
-			if (!ShardData.bSuccess)
+			TArray<TArray<FSpatialHashTableBuilder::FTrajectorySample>> ShardSamples;
+			ShardSamples.SetNum(ShardTimeSteps);
+			
+			const int32 NumShardSamples = ExtractSamplesByTimeStep(
+				MakeArrayView(&Shard->Data, 1), MakeArrayView(&ShardStartTimeStep, 1), ShardStartTimeStep, ShardSamples,
+				BaseConfig.bComputeBoundingBox ? &RunningBounds : nullptr);
+			
+			const int64 ShardSampleBytes = (int64)NumShardSamples * sizeof(FSpatialHashTableBuilder::FTrajectorySample);
+			Budget.Acquire(ShardSampleBytes);
+			NumSamples += NumShardSamples;
+			SampleBytes += ShardSampleBytes;
+			
+			GlobalMinTimeStep = FMath::Min(GlobalMinTimeStep, ShardStartTimeStep);
+			GlobalMaxTimeStep = FMath::Max(GlobalMaxTimeStep, ShardStartTimeStep + ShardTimeSteps - 1);
+			
+			for (int32 LocalTimeStep = 0; LocalTimeStep < ShardTimeSteps; ++LocalTimeStep)
 			{
-				UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Failed to load shard %s in batch: %s"),
-					*ShardFile, *ShardData.ErrorMessage);
-				continue;
+				TimeStepSamples.Add(MoveTemp(ShardSamples[LocalTimeStep]));
+				TimeSteps.Add(ShardStartTimeStep + LocalTimeStep);
 			}
 			
-			UE_LOG(LogTemp, Verbose, TEXT("Loaded shard %s for processing (batch %d-%d)"),
-				*FPaths::GetCleanFilename(ShardFile), BatchStart, BatchEnd - 1);
-			
-			BatchShardData.Add(MoveTemp(ShardData));
-			BatchShardStartTimeSteps.Add(ShardStartTimeSteps[ShardIdx]);
+			// CRITICAL: Free shard data immediately after extraction
+			Budget.Release(Shard->BudgetBytes);
+			Shard.Reset();
+		}
+		
+		if (BaseConfig.bComputeBoundingBox)
+		{
+			TimeStepConfig.BBoxMin = RunningBounds.IsValid ? RunningBounds.Min - Margin : FVector::ZeroVector;
+			TimeStepConfig.BBoxMax = RunningBounds.IsValid ? RunningBounds.Max + Margin : FVector::ZeroVector;
 		}
 		
-		// Process current batch in parallel
-		FThreadSafeCounter BatchSamplesProcessed;
+		// Stage 3: build one hash table per timestep and cell size in parallel
+		TSharedPtr<TArray<FSpatialHashTable>, ESPMode::ThreadSafe> Tables = MakeShared<TArray<FSpatialHashTable>, ESPMode::ThreadSafe>();
+		Tables->SetNum(TimeStepSamples.Num() * NumCellSizes);
+		FThreadSafeBool bTableError(false);
 		
-		ParallelFor(BatchShardData.Num(), [&](int32 BatchIdx)
+		ParallelFor(Tables->Num(), [&](int32 TableIdx)
 		{
-			const FShardFileData& ShardData = BatchShardData[BatchIdx];
-			int32 ShardStartTimeStep = BatchShardStartTimeSteps[BatchIdx];
+			const int32 TimeStepIdx = TableIdx / NumCellSizes;
+			const int32 GlobalTimeStep = TimeSteps[TimeStepIdx];
+			const TArray<FSpatialHashTableBuilder::FTrajectorySample>& Samples = TimeStepSamples[TimeStepIdx];
 			
-			// Process each trajectory entry in this shard
-			for (const FShardTrajectoryEntry& Entry : ShardData.Entries)
+			// Skip empty timesteps (log for debugging)
+			if (Samples.Num() == 0)
 			{
-				// Skip entries with no valid samples
-				if (Entry.ValidSampleCount == 0)
+				UE_LOG(LogTemp, Verbose, TEXT("BuildHashTablesIncrementallyFromShards: Timestep %d has no samples, skipping"),
+					GlobalTimeStep);
+				return;
+			}
+			
+			FSpatialHashTableBuilder::FBuildConfig CellSizeConfig = TimeStepConfig;
+			CellSizeConfig.CellSize = CellSizes[TableIdx % NumCellSizes];
+			
+			FSpatialHashTableBuilder Builder;
+			if (!Builder.BuildHashTableForTimeStep(GlobalTimeStep, Samples, CellSizeConfig, (*Tables)[TableIdx]))
+			{
+				UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to build hash table for timestep %d (cell size %.3f)"),
+					GlobalTimeStep, CellSizeConfig.CellSize);
+				bTableError = true;
+			}
+		});
+		
+		// CRITICAL: Free samples once the tables are built
+		TimeStepSamples.Empty();
+		Budget.Release(SampleBytes);
+		
+		if (bTableError)
+		{
+			bBuildError = true;
+			break;
+		}
+		
+		int64 TableBytes = 0;
+		for (const FSpatialHashTable& Table : *Tables)
+		{
+			TableBytes += Table.GetEntryMemoryBytes() + Table.TrajectoryIds.Num() * sizeof(uint32);
+		}
+		Budget.Acquire(TableBytes);
+		
+		// Stage 4: hand the tables to the writer; only one write is in flight so the disk sees sequential writes
+		if (PendingWrite.IsValid() && !PendingWrite.Get())
+		{
+			Budget.Release(TableBytes);
+			bBuildError = true;
+			break;
+		}
+		
+		// Only the writer touches the manifests until the final write has completed.
+		// Writes run on the thread pool: a dedicated thread per group would be created and torn down for every shard.
+		PendingWrite = Async(EAsyncExecution::ThreadPool, [Tables, TableBytes, NumCellSizes, &Budget, &BaseConfig, &Manifests]()
+		{
+			bool bSuccess = true;
+			for (int32 TableIdx = 0; TableIdx < Tables->Num() && bSuccess; ++TableIdx)
+			{
+				const FSpatialHashTable& Table = (*Tables)[TableIdx];
+				if (Table.Header.NumEntries == 0)
 				{
-					continue;
+					continue; // Empty timestep, nothing was built
 				}
 				
-				// Process each position in the entry
-				for (int32 LocalTimeStep = 0; LocalTimeStep < Entry.Positions.Num(); ++LocalTimeStep)
+				const int32 GlobalTimeStep = (int32)Table.Header.TimeStep;
+				FString Filename = FSpatialHashTableBuilder::GetOutputFilename(BaseConfig.OutputDirectory, Table.Header.CellSize, GlobalTimeStep);
+				FSpatialHashManifest::FTable ManifestTable;
+				if (!Table.SaveToFile(Filename, &ManifestTable.Checksum, &ManifestTable.FileSize, BaseConfig.FileVersion))
 				{
-					const FVector3f& Pos = Entry.Positions[LocalTimeStep];
-					
-					// Skip invalid positions (NaN check for all components)
-					if (FMath::IsNaN(Pos.X) || FMath::IsNaN(Pos.Y) || FMath::IsNaN(Pos.Z))
-					{
-						continue;
-					}
-					
-					// Calculate global time step
-					int32 GlobalTimeStep = ShardStartTimeStep + LocalTimeStep;
-					int32 ArrayIndex = GlobalTimeStep - GlobalMinTimeStep;
-					
-					if (ArrayIndex >= 0 && ArrayIndex < OutTimeStepSamples.Num())
-					{
-						// Convert to FSpatialHashTableBuilder format
-						FVector Position(Pos.X, Pos.Y, Pos.Z);
-						FSpatialHashTableBuilder::FTrajectorySample Sample(static_cast<uint32>(Entry.TrajectoryId), Position);
-						
-						// Thread-safe addition to the output array
-						FScopeLock Lock(&SamplesMutex);
-						OutTimeStepSamples[ArrayIndex].Add(Sample);
-						BatchSamplesProcessed.Increment();
-					}
+					UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to save hash table for timestep %d (cell size %.3f)"),
+						GlobalTimeStep, Table.Header.CellSize);
+					bSuccess = false;
+					continue;
 				}
+				
+				ManifestTable.SetFromHeader(Table.Header);
+				Manifests[TableIdx % NumCellSizes].AddTable(ManifestTable);
 			}
+			
+			Tables->Empty();
+			Budget.Release(TableBytes);
+			return bSuccess;
 		});
 		
-		TotalSamplesProcessed += BatchSamplesProcessed.GetValue();
-		
-		// Free batch data immediately before loading next batch
-		BatchShardData.Empty();
-		BatchShardStartTimeSteps.Empty();
-		
-		UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Completed batch %d-%d, processed %d samples (total: %d)"),
-			BatchStart, BatchEnd - 1, BatchSamplesProcessed.GetValue(), TotalSamplesProcessed);
+		NumShardsProcessed += Group.Num();
+		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: %d shard(s) with %d timesteps built from %d samples, writing (%d/%d shards)"),
+			Group.Num(), TimeSteps.Num(), NumSamples, NumShardsProcessed, ShardFiles.Num());
 	}
 	
-	// Free metadata array
-	ShardStartTimeSteps.Empty();
+	if (PendingWrite.IsValid() && !PendingWrite.Get())
+	{
+		bBuildError = true;
+	}
 	
-	// Verify we have at least some data
-	bool bHasData = false;
-	for (const auto& TimeStepData : OutTimeStepSamples)
+	// Stop the reader (if still running) and release whatever it read ahead
+	Budget.Cancel();
+	ReaderFuture.Wait();
+	LoadedShards.Empty();
+	FPlatformProcess::ReturnSynchEventToPool(ShardLoadedEvent);
+	
+	if (bBuildError)
 	{
-		if (TimeStepData.Num() > 0)
-		{
-			bHasData = true;
-			break;
-		}
+		UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to build hash tables after %d of %d shards"),
+			NumShardsProcessed, ShardFiles.Num());
+		return false;
 	}
 	
-	if (!bHasData)
+	if (NumShardsProcessed == 0)
 	{
-		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: No valid trajectory samples were loaded"));
+		UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to load any shard files"));
 		return false;
 	}
 	
-	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::LoadTrajectoryDataFromDirectory: Loaded %d total samples across %d time steps from %d shards using batch processing"),
-		TotalSamplesProcessed, TotalTimeSteps, TotalShards);
+	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Time range: %d to %d (%d steps)"),
+		GlobalMinTimeStep, GlobalMaxTimeStep, GlobalMaxTimeStep - GlobalMinTimeStep + 1);
+	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Peak resident bytes (shards, samples, unwritten tables): %lld (%.1f MB of %.1f MB budget)"),
+		Budget.GetPeakBytes(), Budget.GetPeakBytes() / (1024.0 * 1024.0), Budget.GetLimitBytes() / (1024.0 * 1024.0));
+	
+	if (BaseConfig.bComputeBoundingBox)
+	{
+		UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Computed BBox: Min(%.2f,%.2f,%.2f) Max(%.2f,%.2f,%.2f)"),
+			TimeStepConfig.BBoxMin.X, TimeStepConfig.BBoxMin.Y, TimeStepConfig.BBoxMin.Z,
+			TimeStepConfig.BBoxMax.X, TimeStepConfig.BBoxMax.Y, TimeStepConfig.BBoxMax.Z);
+	}
+	
+	// Each record carries its table's own bounding box; Finalize() sets the set's box to their union
+	for (FSpatialHashManifest& Manifest : Manifests)
+	{
+		for (const FSpatialHashManifest::FShard& ShardRecord : ShardRecords)
+		{
+			Manifest.AddShard(ShardRecord);
+		}
+		Manifest.Finalize();
+		if (!Manifest.SaveToFile(FSpatialHashManifest::GetManifestFilename(BaseConfig.OutputDirectory, Manifest.CellSize)))
+		{
+			UE_LOG(LogTemp, Error, TEXT("BuildHashTablesIncrementallyFromShards: Failed to save manifest for cell size %.3f"),
+				Manifest.CellSize);
+			return false;
+		}
+	}
+	
+	// A partial build has only seen some shards, so its catalog and index don't describe the dataset
+	if (bReaderCompleted && !ShardFilesToBuild)
+	{
+		{
+			FScopeLock Lock(&ShardCatalogMutex);
+			ShardCatalogs.Add(DatasetDirectory, Catalog);
+		}
+		
+		if (bShardIndexComplete)
+		{
+			ShardIndex->Finalize();
+			ShardIndex->SaveToFile(FTrajectoryShardIndex::GetIndexFilename(DatasetDirectory));
+			
+			FScopeLock Lock(&TrajectoryShardIndexMutex);
+			FCachedTrajectoryShardIndex& CachedIndex = TrajectoryShardIndices.Add(DatasetDirectory);
+			CachedIndex.Index = ShardIndex;
+			CachedIndex.ValidatedCatalog = Catalog;
+		}
+	}
 	
+	UE_LOG(LogTemp, Log, TEXT("BuildHashTablesIncrementallyFromShards: Successfully completed incremental hash table building"));
 	return true;
 }
 
@@ -1133,6 +1751,132 @@ bool USpatialHashTableManager::GetShardFiles(const FString& DatasetDirectory, TA
 	return true;
 }
 
+FDateTime USpatialHashTableManager::GetDirectoryTimeStamp(const FString& DatasetDirectory)
+{
+	FFileStatData StatData = FPlatformFileManager::Get().GetPlatformFile().GetStatData(*DatasetDirectory);
+	if (!StatData.bIsValid || !StatData.bIsDirectory)
+	{
+		return FDateTime::MinValue();
+	}
+	
+	// File systems with coarse time stamps can't tell a change made in the same tick as the
+	// enumeration apart, so a very recent time stamp is not trusted
+	if ((FDateTime::UtcNow() - StatData.ModificationTime).GetTotalSeconds() < 2.0)
+	{
+		return FDateTime::MinValue();
+	}
+	
+	return StatData.ModificationTime;
+}
+
+TSharedPtr<const USpatialHashTableManager::FShardCatalog, ESPMode::ThreadSafe> USpatialHashTableManager::GetShardCatalog(
+	const FString& DatasetDirectory) const
+{
+	// Adding, removing or renaming shards changes the directory's modification time
+	const FDateTime DirectoryTimeStamp = GetDirectoryTimeStamp(DatasetDirectory);
+	
+	FScopeLock Lock(&ShardCatalogMutex);
+	
+	TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe> CachedCatalog = ShardCatalogs.FindRef(DatasetDirectory);
+	if (CachedCatalog.IsValid() && DirectoryTimeStamp != FDateTime::MinValue() &&
+		CachedCatalog->DirectoryTimeStamp == DirectoryTimeStamp)
+	{
+		return CachedCatalog;
+	}
+	
+	TArray<FString> ShardFiles;
+	if (!GetShardFiles(DatasetDirectory, ShardFiles))
+	{
+		ShardCatalogs.Remove(DatasetDirectory);
+		return nullptr;
+	}
+	
+	// Directory changed, but not its shards (e.g. spatial_hashing was created) - only refresh the time stamp
+	if (CachedCatalog.IsValid() && CachedCatalog->ShardFiles == ShardFiles)
+	{
+		if (CachedCatalog->DirectoryTimeStamp != DirectoryTimeStamp)
+		{
+			TSharedPtr<FShardCatalog, ESPMode::ThreadSafe> RefreshedCatalog = MakeShared<FShardCatalog, ESPMode::ThreadSafe>(*CachedCatalog);
+			RefreshedCatalog->DirectoryTimeStamp = DirectoryTimeStamp;
+			ShardCatalogs.Add(DatasetDirectory, RefreshedCatalog);
+			return RefreshedCatalog;
+		}
+		return CachedCatalog;
+	}
+	
+	UTrajectoryDataLoader* Loader = UTrajectoryDataLoader::Get();
+	if (!Loader)
+	{
+		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::GetShardCatalog: Failed to get TrajectoryDataLoader"));
+		return nullptr;
+	}
+	
+	// Header pass: the TrajectoryData plugin only offers full shard decoding, so this runs once per dataset
+	TSharedPtr<FShardCatalog, ESPMode::ThreadSafe> Catalog = MakeShared<FShardCatalog, ESPMode::ThreadSafe>();
+	Catalog->Shards.Reserve(ShardFiles.Num());
+	
+	for (const FString& ShardFile : ShardFiles)
+	{
+		FShardFileData ShardData = Loader->LoadShardFile(ShardFile);
+		if (!ShardData.bSuccess)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::GetShardCatalog: Failed to load shard %s: %s"),
+				*ShardFile, *ShardData.ErrorMessage);
+			continue;
+		}
+		
+		FShardInfo& Info = Catalog->Shards.AddDefaulted_GetRef();
+		Info.FilePath = ShardFile;
+		Info.StartTimeStep = ParseTimestepFromFilename(ShardFile);
+		Info.TimeStepIntervalSize = ShardData.Header.TimeStepIntervalSize;
+		Info.NumTrajectories = ShardData.Entries.Num();
+	}
+	
+	Catalog->ShardFiles = MoveTemp(ShardFiles);
+	Catalog->DirectoryTimeStamp = DirectoryTimeStamp;
+	
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::GetShardCatalog: Cataloged %d of %d shards in %s"),
+		Catalog->Shards.Num(), Catalog->ShardFiles.Num(), *DatasetDirectory);
+	
+	ShardCatalogs.Add(DatasetDirectory, Catalog);
+	return Catalog;
+}
+
+// Append the valid samples of a shard entry that fall into [StartTimeStep, EndTimeStep]
+static void AppendSamplesInTimeRange(
+	const FShardTrajectoryEntry& Entry,
+	int32 ShardStartTimeStep,
+	int32 StartTimeStep,
+	int32 EndTimeStep,
+	TArray<FTrajectorySamplePoint>& OutSamplePoints)
+{
+	for (int32 LocalTimeStep = 0; LocalTimeStep < Entry.Positions.Num(); ++LocalTimeStep)
+	{
+		int32 GlobalTimeStep = ShardStartTimeStep + LocalTimeStep;
+		
+		// Skip samples outside the requested time range
+		if (GlobalTimeStep < StartTimeStep || GlobalTimeStep > EndTimeStep)
+		{
+			continue;
+		}
+		
+		const FVector3f& Pos = Entry.Positions[LocalTimeStep];
+		
+		// Skip invalid positions
+		if (FMath::IsNaN(Pos.X) || FMath::IsNaN(Pos.Y) || FMath::IsNaN(Pos.Z))
+		{
+			continue;
+		}
+		
+		// Add the sample point
+		FTrajectorySamplePoint SamplePoint;
+		SamplePoint.Position = FVector(Pos.X, Pos.Y, Pos.Z);
+		SamplePoint.TimeStep = GlobalTimeStep;
+		SamplePoint.Distance = 0.0f; // Will be calculated later
+		
+		OutSamplePoints.Add(SamplePoint);
+	}
+}
 
 bool USpatialHashTableManager::LoadTrajectorySamplesForIds(
 	const FString& DatasetDirectory,
@@ -1156,17 +1900,15 @@ bool USpatialHashTableManager::LoadTrajectorySamplesForIds(
 		return false;
 	}
 	
-	// Use centralized shard file discovery
-	TArray<FString> ShardFiles;
-	if (!GetShardFiles(DatasetDirectory, ShardFiles))
+	// Shard metadata is cached per dataset, so shards can be pruned without loading them
+	TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe> Catalog = GetShardCatalog(DatasetDirectory);
+	if (!Catalog.IsValid())
 	{
 		UE_LOG(LogTemp, Error, TEXT("USpatialHashTableManager::LoadTrajectorySamplesForIds: Failed to get shard files from %s"),
 			*DatasetDirectory);
 		return false;
 	}
-	
-	// Create a set for fast trajectory ID lookup
-	TSet<uint32> TrajectoryIdSet(TrajectoryIds);
+	const TArray<FString>& ShardFiles = Catalog->ShardFiles;
 	
 	// Initialize output arrays for all requested trajectory IDs
 	for (uint32 TrajId : TrajectoryIds)
@@ -1174,25 +1916,95 @@ bool USpatialHashTableManager::LoadTrajectorySamplesForIds(
 		OutTrajectoryData.Add(TrajId, TArray<FTrajectorySamplePoint>());
 	}
 	
-	// Load data from shards that overlap with the time range
-	for (const FString& ShardFile : ShardFiles)
+	// Fast path: the shard index tells which shards (and which entries in them) hold the requested trajectories
+	TSharedPtr<const FTrajectoryShardIndex, ESPMode::ThreadSafe> ShardIndex = GetTrajectoryShardIndex(DatasetDirectory, Catalog);
+	if (ShardIndex.IsValid())
 	{
-		int32 ShardStartTimeStep = ParseTimestepFromFilename(ShardFile);
+		const TArray<FTrajectoryShardIndex::FShard>& Shards = ShardIndex->GetShards();
 		
-		// Load the shard using TrajectoryData plugin API
-		FShardFileData ShardData = Loader->LoadShardFile(ShardFile);
-		if (!ShardData.bSuccess)
+		// Group the requested entries by shard, skipping shards outside the time range
+		TArray<TArray<TPair<uint32, uint32>>> EntriesPerShard; // (EntryIndex, TrajectoryId)
+		EntriesPerShard.SetNum(Shards.Num());
+		for (const auto& Pair : OutTrajectoryData)
 		{
-			UE_LOG(LogTemp, Warning, TEXT("LoadTrajectorySamplesForIds: Failed to load shard %s: %s"),
-				*ShardFile, *ShardData.ErrorMessage);
-			continue;
+			for (const FTrajectoryShardIndex::FLocation& Location : ShardIndex->FindLocations(Pair.Key))
+			{
+				const FTrajectoryShardIndex::FShard& Shard = Shards[Location.ShardIndex];
+				if (Shard.GetEndTimeStep() < StartTimeStep || Shard.StartTimeStep > EndTimeStep)
+				{
+					continue;
+				}
+				EntriesPerShard[Location.ShardIndex].Emplace(Location.EntryIndex, Pair.Key);
+			}
+		}
+		
+		bool bIndexStale = false;
+		for (int32 ShardIdx = 0; ShardIdx < Shards.Num() && !bIndexStale; ++ShardIdx)
+		{
+			if (EntriesPerShard[ShardIdx].Num() == 0)
+			{
+				continue;
+			}
+			
+			FShardFileData ShardData = Loader->LoadShardFile(ShardFiles[ShardIdx]);
+			if (!ShardData.bSuccess)
+			{
+				UE_LOG(LogTemp, Warning, TEXT("LoadTrajectorySamplesForIds: Failed to load shard %s: %s"),
+					*ShardFiles[ShardIdx], *ShardData.ErrorMessage);
+				continue;
+			}
+			
+			for (const TPair<uint32, uint32>& Requested : EntriesPerShard[ShardIdx])
+			{
+				if (!ShardData.Entries.IsValidIndex(Requested.Key) ||
+					(uint32)ShardData.Entries[Requested.Key].TrajectoryId != Requested.Value)
+				{
+					bIndexStale = true;
+					break;
+				}
+				
+				AppendSamplesInTimeRange(ShardData.Entries[Requested.Key], Shards[ShardIdx].StartTimeStep,
+					StartTimeStep, EndTimeStep, OutTrajectoryData.FindChecked(Requested.Value));
+			}
+		}
+		
+		if (!bIndexStale)
+		{
+			return true;
 		}
 		
-		int32 ShardEndTimeStep = ShardStartTimeStep + ShardData.Header.TimeStepIntervalSize - 1;
+		// Shard contents changed without changing names or sizes - drop the index and scan all shards
+		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::LoadTrajectorySamplesForIds: Trajectory shard index of %s is stale, scanning all shards"),
+			*DatasetDirectory);
+		{
+			FScopeLock Lock(&TrajectoryShardIndexMutex);
+			TrajectoryShardIndices.Remove(DatasetDirectory);
+		}
+		IFileManager::Get().Delete(*FTrajectoryShardIndex::GetIndexFilename(DatasetDirectory));
+		for (auto& Pair : OutTrajectoryData)
+		{
+			Pair.Value.Reset();
+		}
+	}
+	
+	// Create a set for fast trajectory ID lookup
+	TSet<uint32> TrajectoryIdSet(TrajectoryIds);
+	
+	// Load data from shards that overlap with the time range
+	for (const FShardInfo& Shard : Catalog->Shards)
+	{
+		// Skip shards that don't overlap with our time range before touching their payload
+		if (!Shard.OverlapsTimeRange(StartTimeStep, EndTimeStep))
+		{
+			continue;
+		}
 		
-		// Skip shards that don't overlap with our time range
-		if (ShardEndTimeStep < StartTimeStep || ShardStartTimeStep > EndTimeStep)
+		// Load the shard using TrajectoryData plugin API
+		FShardFileData ShardData = Loader->LoadShardFile(Shard.FilePath);
+		if (!ShardData.bSuccess)
 		{
+			UE_LOG(LogTemp, Warning, TEXT("LoadTrajectorySamplesForIds: Failed to load shard %s: %s"),
+				*Shard.FilePath, *ShardData.ErrorMessage);
 			continue;
 		}
 		
@@ -1205,75 +2017,83 @@ bool USpatialHashTableManager::LoadTrajectorySamplesForIds(
 				continue;
 			}
 			
-			// Get or create the array for this trajectory
-			TArray<FTrajectorySamplePoint>& SamplePoints = OutTrajectoryData.FindOrAdd(Entry.TrajectoryId);
-			
-			// Add samples that fall within the time range
-			for (int32 LocalTimeStep = 0; LocalTimeStep < Entry.Positions.Num(); ++LocalTimeStep)
-			{
-				int32 GlobalTimeStep = ShardStartTimeStep + LocalTimeStep;
-				
-				// Skip samples outside the requested time range
-				if (GlobalTimeStep < StartTimeStep || GlobalTimeStep > EndTimeStep)
-				{
-					continue;
-				}
-				
-				const FVector3f& Pos = Entry.Positions[LocalTimeStep];
-				
-				// Skip invalid positions
-				if (FMath::IsNaN(Pos.X) || FMath::IsNaN(Pos.Y) || FMath::IsNaN(Pos.Z))
-				{
-					continue;
-				}
-				
-				// Add the sample point
-				FTrajectorySamplePoint SamplePoint;
-				SamplePoint.Position = FVector(Pos.X, Pos.Y, Pos.Z);
-				SamplePoint.TimeStep = GlobalTimeStep;
-				SamplePoint.Distance = 0.0f; // Will be calculated later
-				
-				SamplePoints.Add(SamplePoint);
-			}
+			AppendSamplesInTimeRange(Entry, Shard.StartTimeStep, StartTimeStep, EndTimeStep,
+				OutTrajectoryData.FindOrAdd(Entry.TrajectoryId));
 		}
 	}
 	
 	return true;
 }
 
-FString USpatialHashTableManager::FindShardFileForTimeStep(const FString& DatasetDirectory, int32 TimeStep) const
+TSharedPtr<const FTrajectoryShardIndex, ESPMode::ThreadSafe> USpatialHashTableManager::GetTrajectoryShardIndex(
+	const FString& DatasetDirectory,
+	const TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe>& Catalog) const
 {
-	// Use centralized shard file discovery
-	TArray<FString> ShardFiles;
-	if (!GetShardFiles(DatasetDirectory, ShardFiles))
-	{
-		return FString();
-	}
+	const TArray<FString>& ShardFiles = Catalog->ShardFiles;
 	
-	// Get TrajectoryDataLoader to read shard headers using its API
-	UTrajectoryDataLoader* Loader = UTrajectoryDataLoader::Get();
-	if (!Loader)
+	FScopeLock Lock(&TrajectoryShardIndexMutex);
+	
+	if (FCachedTrajectoryShardIndex* CachedIndex = TrajectoryShardIndices.Find(DatasetDirectory))
 	{
-		return FString();
+		// Same catalog as last time: the shard files are unchanged, skip stat'ing them
+		if (CachedIndex->ValidatedCatalog == Catalog)
+		{
+			return CachedIndex->Index;
+		}
+		if (CachedIndex->Index->IsUpToDate(ShardFiles))
+		{
+			CachedIndex->ValidatedCatalog = Catalog;
+			return CachedIndex->Index;
+		}
+		TrajectoryShardIndices.Remove(DatasetDirectory);
 	}
 	
-	// Find the shard that contains this timestep
-	for (const FString& ShardFile : ShardFiles)
+	TSharedPtr<FTrajectoryShardIndex, ESPMode::ThreadSafe> ShardIndex = MakeShared<FTrajectoryShardIndex, ESPMode::ThreadSafe>();
+	const FString IndexFilename = FTrajectoryShardIndex::GetIndexFilename(DatasetDirectory);
+	
+	if (!ShardIndex->LoadFromFile(IndexFilename) || !ShardIndex->IsUpToDate(ShardFiles))
 	{
-		int32 ShardStartTimeStep = ParseTimestepFromFilename(ShardFile);
+		UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::GetTrajectoryShardIndex: Building trajectory shard index for %s"),
+			*DatasetDirectory);
 		
-		// Use TrajectoryData plugin's LoadShardFile API to get the header
-		FShardFileData ShardData = Loader->LoadShardFile(ShardFile);
-		if (!ShardData.bSuccess)
+		TArray<int32> ShardStartTimeSteps;
+		ShardStartTimeSteps.Reserve(ShardFiles.Num());
+		for (const FString& ShardFile : ShardFiles)
 		{
-			continue;
+			ShardStartTimeSteps.Add(ParseTimestepFromFilename(ShardFile));
 		}
 		
-		int32 ShardEndTimeStep = ShardStartTimeStep + ShardData.Header.TimeStepIntervalSize - 1;
+		if (!ShardIndex->Build(ShardFiles, ShardStartTimeSteps))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::GetTrajectoryShardIndex: Failed to build trajectory shard index for %s"),
+				*DatasetDirectory);
+			return nullptr;
+		}
 		
-		if (TimeStep >= ShardStartTimeStep && TimeStep <= ShardEndTimeStep)
+		// An index that cannot be persisted is still useful for this session
+		ShardIndex->SaveToFile(IndexFilename);
+	}
+	
+	FCachedTrajectoryShardIndex& NewCachedIndex = TrajectoryShardIndices.Add(DatasetDirectory);
+	NewCachedIndex.Index = ShardIndex;
+	NewCachedIndex.ValidatedCatalog = Catalog;
+	return ShardIndex;
+}
+
+FString USpatialHashTableManager::FindShardFileForTimeStep(const FString& DatasetDirectory, int32 TimeStep) const
+{
+	TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe> Catalog = GetShardCatalog(DatasetDirectory);
+	if (!Catalog.IsValid())
+	{
+		return FString();
+	}
+	
+	// Find the shard that contains this timestep
+	for (const FShardInfo& Shard : Catalog->Shards)
+	{
+		if (Shard.OverlapsTimeRange(TimeStep, TimeStep))
 		{
-			return ShardFile;
+			return Shard.FilePath;
 		}
 	}
 	
@@ -1493,6 +2313,76 @@ int32 USpatialHashTableManager::QueryRadiusWithDistanceCheck(
 	return OutResults.Num();
 }
 
+bool USpatialHashTableManager::VerifyHashTables(const FString& DatasetDirectory, float CellSize) const
+{
+	FSpatialHashManifest Manifest;
+	if (!Manifest.LoadFromFile(FSpatialHashManifest::GetManifestFilename(DatasetDirectory, CellSize)))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::VerifyHashTables: No manifest for cell size %.3f in %s"),
+			CellSize, *DatasetDirectory);
+		return false;
+	}
+	
+	const TArray<FSpatialHashManifest::FTable>& RecordedTables = Manifest.GetTables();
+	FThreadSafeCounter NumMismatches;
+	ParallelFor(RecordedTables.Num(), [&](int32 Index)
+	{
+		if (!Manifest.VerifyTableFile(DatasetDirectory, RecordedTables[Index].TimeStep))
+		{
+			NumMismatches.Increment();
+		}
+	});
+	
+	UE_LOG(LogTemp, Log, TEXT("USpatialHashTableManager::VerifyHashTables: %d of %d tables for cell size %.3f match the manifest"),
+		RecordedTables.Num() - NumMismatches.GetValue(), RecordedTables.Num(), CellSize);
+	
+	return NumMismatches.GetValue() == 0;
+}
+
+float USpatialHashTableManager::SelectCellSizeForRadius(float Radius, int32 TimeStep) const
+{
+	const float SafeRadius = FMath::Max(Radius, KINDA_SMALL_NUMBER);
+	float BestCellSize = 0.0f;
+	float BestMismatch = MAX_flt;
+	
+	for (const auto& Pair : LoadedHashTables)
+	{
+		if (Pair.Key.TimeStep != TimeStep)
+		{
+			continue;
+		}
+		
+		// Distance on a log scale: half and double the radius are equally good; ties go to the finer level
+		const float Mismatch = FMath::Abs(FMath::Loge(Pair.Key.CellSize / SafeRadius));
+		if (Mismatch < BestMismatch || (Mismatch == BestMismatch && Pair.Key.CellSize < BestCellSize))
+		{
+			BestMismatch = Mismatch;
+			BestCellSize = Pair.Key.CellSize;
+		}
+	}
+	
+	return BestCellSize;
+}
+
+int32 USpatialHashTableManager::QueryRadiusWithDistanceCheckAtBestLevel(
+	const FString& DatasetDirectory,
+	FVector QueryPosition,
+	float Radius,
+	int32 TimeStep,
+	TArray<FSpatialHashQueryResult>& OutResults)
+{
+	const float CellSize = SelectCellSizeForRadius(Radius, TimeStep);
+	if (CellSize <= 0.0f)
+	{
+		OutResults.Reset();
+		UE_LOG(LogTemp, Warning, TEXT("USpatialHashTableManager::QueryRadiusWithDistanceCheckAtBestLevel: No hash table loaded for time step %d"),
+			TimeStep);
+		return 0;
+	}
+	
+	return QueryRadiusWithDistanceCheck(DatasetDirectory, QueryPosition, Radius, CellSize, TimeStep, OutResults);
+}
+
 int32 USpatialHashTableManager::QueryDualRadiusWithDistanceCheck(
 	const FString& DatasetDirectory,
 	FVector QueryPosition,
@@ -1566,7 +2456,8 @@ int32 USpatialHashTableManager::QueryRadiusOverTimeRange(
 	}
 	
 	// Collect all unique trajectory IDs across the time range
-	TSet<uint32> AllTrajectoryIds;
+	FTrajectoryIdSet AllTrajectoryIds;
+	TArray<uint32> TimeStepTrajectoryIds;
 	
 	for (int32 TimeStep = StartTimeStep; TimeStep <= EndTimeStep; ++TimeStep)
 	{
@@ -1578,13 +2469,9 @@ int32 USpatialHashTableManager::QueryRadiusOverTimeRange(
 			continue;
 		}
 		
-		TArray<uint32> TimeStepTrajectoryIds;
 		HashTable->QueryTrajectoryIdsInRadius(QueryPosition, Radius, TimeStepTrajectoryIds);
 		
-		for (uint32 TrajId : TimeStepTrajectoryIds)
-		{
-			AllTrajectoryIds.Add(TrajId);
-		}
+		AllTrajectoryIds.Append(TimeStepTrajectoryIds);
 	}
 	
 	if (AllTrajectoryIds.Num() == 0)
@@ -1645,7 +2532,8 @@ int32 USpatialHashTableManager::QueryTrajectoryRadiusOverTimeRange(
 	}
 	
 	// Collect all unique trajectory IDs across all query points in the time range
-	TSet<uint32> AllTrajectoryIds;
+	FTrajectoryIdSet AllTrajectoryIds;
+	TArray<uint32> TimeStepTrajectoryIds;
 	
 	for (const FTrajectorySamplePoint& QuerySample : *QuerySamples)
 	{
@@ -1657,19 +2545,13 @@ int32 USpatialHashTableManager::QueryTrajectoryRadiusOverTimeRange(
 			continue;
 		}
 		
-		TArray<uint32> TimeStepTrajectoryIds;
 		HashTable->QueryTrajectoryIdsInRadius(QuerySample.Position, Radius, TimeStepTrajectoryIds);
-		
-		for (uint32 TrajId : TimeStepTrajectoryIds)
-		{
-			// Don't include the query trajectory itself
-			if (TrajId != (uint32)QueryTrajectoryId)
-			{
-				AllTrajectoryIds.Add(TrajId);
-			}
-		}
+		AllTrajectoryIds.Append(TimeStepTrajectoryIds);
 	}
 	
+	// Don't include the query trajectory itself
+	AllTrajectoryIds.Remove((uint32)QueryTrajectoryId);
+	
 	if (AllTrajectoryIds.Num() == 0)
 	{
 		return 0;
@@ -1927,14 +2809,14 @@ void USpatialHashTableManager::QueryRadiusOverTimeRangeAsync(
 	FOnSpatialHashQueryComplete OnComplete)
 {
 	// Gather candidate trajectory IDs from all timesteps in range
-	TSet<uint32> AllCandidateIds;
+	FTrajectoryIdSet AllCandidateIds;
+	TArray<uint32> CandidateIds;
 	
 	for (int32 TimeStep = StartTimeStep; TimeStep <= EndTimeStep; ++TimeStep)
 	{
 		FSpatialHashTable* HashTable = GetOrLoadHashTable(DatasetDirectory, CellSize, TimeStep);
 		if (HashTable)
 		{
-			TArray<uint32> CandidateIds;
 			HashTable->QueryTrajectoryIdsInRadius(QueryPosition, Radius, CandidateIds);
 			AllCandidateIds.Append(CandidateIds);
 		}
@@ -2083,13 +2965,13 @@ void USpatialHashTableManager::QueryTrajectoryRadiusOverTimeRangeAsync(
 			}
 			
 			// Gather candidate trajectory IDs from spatial hash
-			TSet<uint32> AllCandidateIds;
+			FTrajectoryIdSet AllCandidateIds;
+			TArray<uint32> CandidateIds;
 			for (const FTrajectorySamplePoint& QuerySample : QuerySamples)
 			{
 				FSpatialHashTable* HashTable = GetOrLoadHashTable(DatasetDirectory, CellSize, QuerySample.TimeStep);
 				if (HashTable)
 				{
-					TArray<uint32> CandidateIds;
 					HashTable->QueryTrajectoryIdsInRadius(QuerySample.Position, Radius, CandidateIds);
 					AllCandidateIds.Append(CandidateIds);
 				}
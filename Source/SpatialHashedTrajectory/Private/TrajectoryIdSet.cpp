@@ -0,0 +1,252 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "TrajectoryIdSet.h"
+
+FTrajectoryIdSet::FTrajectoryIdSet(uint32 InMaxDenseId)
+	: DenseCount(0)
+	, MaxDenseId(InMaxDenseId)
+	, bDense(true)
+{
+}
+
+void FTrajectoryIdSet::Reset()
+{
+	if (bDense)
+	{
+		// Only clear the words the population index marks as non-empty
+		for (int32 SummaryIndex = 0; SummaryIndex < Summary.Num(); ++SummaryIndex)
+		{
+			uint64 SummaryBits = Summary[SummaryIndex];
+			while (SummaryBits != 0)
+			{
+				Words[SummaryIndex * 64 + (int32)FMath::CountTrailingZeros64(SummaryBits)] = 0;
+				SummaryBits &= SummaryBits - 1;
+			}
+			Summary[SummaryIndex] = 0;
+		}
+	}
+
+	SparseIds.Reset();
+	DenseCount = 0;
+	bDense = true;
+}
+
+bool FTrajectoryIdSet::Add(uint32 Id)
+{
+	if (bDense && Id >= MaxDenseId)
+	{
+		ConvertToSparse();
+	}
+
+	if (!bDense)
+	{
+		bool bAlreadyInSet = false;
+		SparseIds.Add(Id, &bAlreadyInSet);
+		return !bAlreadyInSet;
+	}
+
+	const int32 WordIndex = (int32)(Id >> 6);
+	const uint64 BitMask = 1ull << (Id & 63);
+	EnsureDenseCapacity(WordIndex);
+
+	if (Words[WordIndex] & BitMask)
+	{
+		return false;
+	}
+
+	Words[WordIndex] |= BitMask;
+	Summary[WordIndex >> 6] |= 1ull << (WordIndex & 63);
+	++DenseCount;
+	return true;
+}
+
+void FTrajectoryIdSet::Append(TArrayView<const uint32> Ids)
+{
+	for (uint32 Id : Ids)
+	{
+		Add(Id);
+	}
+}
+
+bool FTrajectoryIdSet::Remove(uint32 Id)
+{
+	if (!bDense)
+	{
+		return SparseIds.Remove(Id) > 0;
+	}
+
+	const int32 WordIndex = (int32)(Id >> 6);
+	const uint64 BitMask = 1ull << (Id & 63);
+	if (Id >= MaxDenseId || WordIndex >= Words.Num() || !(Words[WordIndex] & BitMask))
+	{
+		return false;
+	}
+
+	Words[WordIndex] &= ~BitMask;
+	if (Words[WordIndex] == 0)
+	{
+		Summary[WordIndex >> 6] &= ~(1ull << (WordIndex & 63));
+	}
+	--DenseCount;
+	return true;
+}
+
+bool FTrajectoryIdSet::Contains(uint32 Id) const
+{
+	if (!bDense)
+	{
+		return SparseIds.Contains(Id);
+	}
+
+	const int32 WordIndex = (int32)(Id >> 6);
+	return Id < MaxDenseId && WordIndex < Words.Num() && (Words[WordIndex] & (1ull << (Id & 63))) != 0;
+}
+
+void FTrajectoryIdSet::Union(const FTrajectoryIdSet& Other)
+{
+	if (&Other == this)
+	{
+		return;
+	}
+
+	// Word-wise merge needs both bitsets and room for all of Other's words
+	if (!bDense || !Other.bDense || Other.MaxDenseId > MaxDenseId)
+	{
+		Other.ForEach([this](uint32 Id) { Add(Id); });
+		return;
+	}
+
+	if (Other.Words.Num() > 0)
+	{
+		EnsureDenseCapacity(Other.Words.Num() - 1);
+	}
+
+	// OR only the words that are non-empty in Other
+	for (int32 SummaryIndex = 0; SummaryIndex < Other.Summary.Num(); ++SummaryIndex)
+	{
+		uint64 SummaryBits = Other.Summary[SummaryIndex];
+		if (SummaryBits == 0)
+		{
+			continue;
+		}
+
+		Summary[SummaryIndex] |= SummaryBits;
+		while (SummaryBits != 0)
+		{
+			const int32 WordIndex = SummaryIndex * 64 + (int32)FMath::CountTrailingZeros64(SummaryBits);
+			SummaryBits &= SummaryBits - 1;
+
+			const uint64 OldBits = Words[WordIndex];
+			const uint64 NewBits = OldBits | Other.Words[WordIndex];
+			DenseCount += FMath::CountBits(NewBits) - FMath::CountBits(OldBits);
+			Words[WordIndex] = NewBits;
+		}
+	}
+}
+
+void FTrajectoryIdSet::Intersect(const FTrajectoryIdSet& Other)
+{
+	if (&Other == this)
+	{
+		return;
+	}
+
+	if (!bDense)
+	{
+		for (TSet<uint32>::TIterator It = SparseIds.CreateIterator(); It; ++It)
+		{
+			if (!Other.Contains(*It))
+			{
+				It.RemoveCurrent();
+			}
+		}
+		return;
+	}
+
+	if (!Other.bDense)
+	{
+		TArray<uint32> IdsToRemove;
+		ForEach([&Other, &IdsToRemove](uint32 Id)
+		{
+			if (!Other.Contains(Id))
+			{
+				IdsToRemove.Add(Id);
+			}
+		});
+		for (uint32 Id : IdsToRemove)
+		{
+			Remove(Id);
+		}
+		return;
+	}
+
+	// AND only the words that are non-empty here
+	for (int32 SummaryIndex = 0; SummaryIndex < Summary.Num(); ++SummaryIndex)
+	{
+		uint64 SummaryBits = Summary[SummaryIndex];
+		while (SummaryBits != 0)
+		{
+			const int32 WordIndex = SummaryIndex * 64 + (int32)FMath::CountTrailingZeros64(SummaryBits);
+			SummaryBits &= SummaryBits - 1;
+
+			const uint64 OldBits = Words[WordIndex];
+			const uint64 NewBits = WordIndex < Other.Words.Num() ? (OldBits & Other.Words[WordIndex]) : 0;
+			if (NewBits != OldBits)
+			{
+				DenseCount -= FMath::CountBits(OldBits) - FMath::CountBits(NewBits);
+				Words[WordIndex] = NewBits;
+				if (NewBits == 0)
+				{
+					Summary[SummaryIndex] &= ~(1ull << (WordIndex & 63));
+				}
+			}
+		}
+	}
+}
+
+void FTrajectoryIdSet::ToArray(TArray<uint32>& OutIds) const
+{
+	OutIds.Reset(Num());
+	ForEach([&OutIds](uint32 Id) { OutIds.Add(Id); });
+
+	// Dense iteration is already ascending
+	if (!bDense)
+	{
+		OutIds.Sort();
+	}
+}
+
+TArray<uint32> FTrajectoryIdSet::Array() const
+{
+	TArray<uint32> Result;
+	ToArray(Result);
+	return Result;
+}
+
+void FTrajectoryIdSet::EnsureDenseCapacity(int32 WordIndex)
+{
+	if (WordIndex < Words.Num())
+	{
+		return;
+	}
+
+	// Grow geometrically, but never beyond what MaxDenseId can address
+	// (in 64 bits, so bounds close to MAX_uint32 cannot wrap around to zero words)
+	const int32 MaxWords = (int32)FMath::Min<uint64>(((uint64)MaxDenseId + 63) / 64, (uint64)MAX_int32);
+	const int32 NewNumWords = FMath::Min(FMath::Max(WordIndex + 1, Words.Num() * 2), MaxWords);
+
+	Words.SetNumZeroed(NewNumWords);
+	Summary.SetNumZeroed((NewNumWords + 63) / 64);
+}
+
+void FTrajectoryIdSet::ConvertToSparse()
+{
+	SparseIds.Reserve(DenseCount);
+	ForEach([this](uint32 Id) { SparseIds.Add(Id); });
+
+	// Clears the bitset while still in dense mode, then switch over
+	TSet<uint32> MovedIds = MoveTemp(SparseIds);
+	Reset();
+	SparseIds = MoveTemp(MovedIds);
+	bDense = false;
+}
@@ -0,0 +1,190 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "TrajectoryShardIndex.h"
+#include "TrajectoryDataLoader.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Algo/BinarySearch.h"
+
+FString FTrajectoryShardIndex::GetIndexFilename(const FString& DatasetDirectory)
+{
+	return FPaths::Combine(DatasetDirectory, TEXT("spatial_hashing"), TEXT("trajectory_shard_index.bin"));
+}
+
+void FTrajectoryShardIndex::Reset()
+{
+	Shards.Reset();
+	Locations.Reset();
+}
+
+void FTrajectoryShardIndex::AddShard(const FString& ShardFile, int32 StartTimeStep, const FShardFileData& ShardData)
+{
+	const uint32 ShardIndex = (uint32)Shards.Num();
+
+	FShard& Shard = Shards.AddDefaulted_GetRef();
+	Shard.FileName = FPaths::GetCleanFilename(ShardFile);
+	Shard.FileSize = FPlatformFileManager::Get().GetPlatformFile().FileSize(*ShardFile);
+	Shard.StartTimeStep = StartTimeStep;
+	Shard.TimeStepIntervalSize = ShardData.Header.TimeStepIntervalSize;
+
+	for (int32 EntryIndex = 0; EntryIndex < ShardData.Entries.Num(); ++EntryIndex)
+	{
+		const FShardTrajectoryEntry& Entry = ShardData.Entries[EntryIndex];
+
+		// Trajectories without samples in this shard never need it to be loaded
+		if (Entry.ValidSampleCount == 0)
+		{
+			continue;
+		}
+
+		FLocation& Location = Locations.AddDefaulted_GetRef();
+		Location.TrajectoryId = (uint32)Entry.TrajectoryId;
+		Location.ShardIndex = ShardIndex;
+		Location.EntryIndex = (uint32)EntryIndex;
+		Location.ValidSampleCount = (uint32)Entry.ValidSampleCount;
+	}
+}
+
+void FTrajectoryShardIndex::Finalize()
+{
+	Locations.Sort([](const FLocation& A, const FLocation& B)
+	{
+		return A.TrajectoryId != B.TrajectoryId ? A.TrajectoryId < B.TrajectoryId : A.ShardIndex < B.ShardIndex;
+	});
+}
+
+bool FTrajectoryShardIndex::Build(const TArray<FString>& ShardFiles, const TArray<int32>& ShardStartTimeSteps)
+{
+	Reset();
+
+	if (ShardFiles.Num() != ShardStartTimeSteps.Num())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FTrajectoryShardIndex::Build: Got %d shard files but %d start time steps"),
+			ShardFiles.Num(), ShardStartTimeSteps.Num());
+		return false;
+	}
+
+	UTrajectoryDataLoader* Loader = UTrajectoryDataLoader::Get();
+	if (!Loader)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FTrajectoryShardIndex::Build: Failed to get TrajectoryDataLoader"));
+		return false;
+	}
+
+	for (int32 ShardIdx = 0; ShardIdx < ShardFiles.Num(); ++ShardIdx)
+	{
+		FShardFileData ShardData = Loader->LoadShardFile(ShardFiles[ShardIdx]);
+		if (!ShardData.bSuccess)
+		{
+			// A shard that cannot be indexed makes the index incomplete - don't hand out a partial one
+			UE_LOG(LogTemp, Warning, TEXT("FTrajectoryShardIndex::Build: Failed to load shard %s: %s"),
+				*ShardFiles[ShardIdx], *ShardData.ErrorMessage);
+			Reset();
+			return false;
+		}
+
+		AddShard(ShardFiles[ShardIdx], ShardStartTimeSteps[ShardIdx], ShardData);
+	}
+
+	Finalize();
+
+	UE_LOG(LogTemp, Log, TEXT("FTrajectoryShardIndex::Build: Indexed %d trajectory locations in %d shards"),
+		Locations.Num(), Shards.Num());
+
+	return Shards.Num() > 0;
+}
+
+bool FTrajectoryShardIndex::IsUpToDate(const TArray<FString>& ShardFiles) const
+{
+	if (ShardFiles.Num() != Shards.Num())
+	{
+		return false;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	for (int32 i = 0; i < ShardFiles.Num(); ++i)
+	{
+		if (Shards[i].FileName != FPaths::GetCleanFilename(ShardFiles[i]) ||
+			Shards[i].FileSize != PlatformFile.FileSize(*ShardFiles[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+TArrayView<const FTrajectoryShardIndex::FLocation> FTrajectoryShardIndex::FindLocations(uint32 TrajectoryId) const
+{
+	const int32 First = Algo::LowerBoundBy(Locations, TrajectoryId, &FLocation::TrajectoryId);
+	const int32 Last = Algo::UpperBoundBy(Locations, TrajectoryId, &FLocation::TrajectoryId);
+	return TArrayView<const FLocation>(Locations.GetData() + First, Last - First);
+}
+
+bool FTrajectoryShardIndex::SaveToFile(const FString& Filename) const
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	FString Directory = FPaths::GetPath(Filename);
+	if (!Directory.IsEmpty() && !PlatformFile.DirectoryExists(*Directory))
+	{
+		PlatformFile.CreateDirectoryTree(*Directory);
+	}
+
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FTrajectoryShardIndex::SaveToFile: Failed to open file for writing: %s"), *Filename);
+		return false;
+	}
+
+	uint32 FileMagic = Magic;
+	uint32 FileVersion = Version;
+	*Writer << FileMagic << FileVersion;
+	*Writer << const_cast<TArray<FShard>&>(Shards);
+	*Writer << const_cast<TArray<FLocation>&>(Locations);
+
+	if (!Writer->Close())
+	{
+		UE_LOG(LogTemp, Error, TEXT("FTrajectoryShardIndex::SaveToFile: Failed to write %s"), *Filename);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FTrajectoryShardIndex::SaveToFile: Successfully saved to %s"), *Filename);
+	return true;
+}
+
+bool FTrajectoryShardIndex::LoadFromFile(const FString& Filename)
+{
+	Reset();
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Filename));
+	if (!Reader)
+	{
+		return false;
+	}
+
+	uint32 FileMagic = 0;
+	uint32 FileVersion = 0;
+	*Reader << FileMagic << FileVersion;
+
+	if (FileMagic != Magic || FileVersion != Version)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FTrajectoryShardIndex::LoadFromFile: Unsupported index file %s (magic 0x%08X, version %u)"),
+			*Filename, FileMagic, FileVersion);
+		return false;
+	}
+
+	*Reader << Shards;
+	*Reader << Locations;
+
+	if (Reader->IsError())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FTrajectoryShardIndex::LoadFromFile: Failed to read %s"), *Filename);
+		Reset();
+		return false;
+	}
+
+	return true;
+}
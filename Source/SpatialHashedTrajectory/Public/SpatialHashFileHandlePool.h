@@ -0,0 +1,101 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+
+/**
+ * Process-wide pool of open read handles for spatial hash table files
+ *
+ * On-demand trajectory ID reads used to open, seek, read and close the timestep
+ * file for every single cell. The pool keeps recently used files open and serves
+ * positional reads from them, so a radius query opens each file at most once.
+ * The least recently used handle is closed once MaxOpenHandles is reached, which
+ * keeps fd usage bounded no matter how many hash tables are loaded.
+ */
+class SPATIALHASHEDTRAJECTORY_API FSpatialHashFileHandlePool
+{
+public:
+	/** Default upper bound for simultaneously open handles */
+	static constexpr int32 DefaultMaxOpenHandles = 64;
+
+	/** Get the shared pool instance */
+	static FSpatialHashFileHandlePool& Get();
+
+	/**
+	 * Read a byte range from a file (pread-style, thread-safe)
+	 * Concurrent reads of the same file are serialized on that file's handle only.
+	 *
+	 * @param Filename Path of the file to read from
+	 * @param Offset Absolute byte offset to start reading at
+	 * @param NumBytes Number of bytes to read
+	 * @param Destination Output buffer, must hold at least NumBytes bytes
+	 * @return true if all bytes were read, false otherwise
+	 */
+	bool ReadAt(const FString& Filename, int64 Offset, int64 NumBytes, uint8* Destination);
+
+	/**
+	 * Close the pooled handle for a file (if any)
+	 * Must be called before a file is rewritten, since some platforms do not allow
+	 * writing to a file that is held open for reading.
+	 *
+	 * @param Filename Path of the file to release
+	 */
+	void Release(const FString& Filename);
+
+	/** Close all pooled handles */
+	void ReleaseAll();
+
+	/**
+	 * Set the maximum number of simultaneously open handles
+	 * Excess handles are closed immediately in least recently used order.
+	 *
+	 * @param InMaxOpenHandles New upper bound (clamped to at least 1)
+	 */
+	void SetMaxOpenHandles(int32 InMaxOpenHandles);
+
+	/** Get the maximum number of simultaneously open handles */
+	int32 GetMaxOpenHandles() const;
+
+	/** Get the number of currently open handles */
+	int32 GetNumOpenHandles() const;
+
+private:
+	/**
+	 * One open file handle with its own read lock
+	 * Seek + Read on a shared IFileHandle is not atomic, so every positional read
+	 * holds ReadMutex for the duration of both calls.
+	 */
+	struct FPooledHandle
+	{
+		TUniquePtr<IFileHandle> Handle;
+		FCriticalSection ReadMutex;
+		uint64 LastUseTick = 0;
+	};
+
+	FSpatialHashFileHandlePool() = default;
+
+	/**
+	 * Get the pooled handle for a file, opening it if necessary
+	 * @param Filename Path of the file
+	 * @return Shared handle, or nullptr if the file could not be opened
+	 */
+	TSharedPtr<FPooledHandle, ESPMode::ThreadSafe> Acquire(const FString& Filename);
+
+	/** Close least recently used handles until the pool fits MaxOpenHandles (PoolMutex must be held) */
+	void EvictExcessHandles();
+
+	/** Protects Handles, UseCounter and MaxOpenHandles */
+	mutable FCriticalSection PoolMutex;
+
+	/** Open handles keyed by filename */
+	TMap<FString, TSharedPtr<FPooledHandle, ESPMode::ThreadSafe>> Handles;
+
+	/** Monotonic counter used as LRU timestamp */
+	uint64 UseCounter = 0;
+
+	/** Upper bound for simultaneously open handles */
+	int32 MaxOpenHandles = DefaultMaxOpenHandles;
+};
@@ -0,0 +1,228 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FSpatialHashHeader;
+
+/**
+ * Manifest describing the hash table set of one cell size
+ *
+ * Written next to the tables as <DatasetDirectory>/spatial_hashing/cellsize_X/manifest.bin
+ * at the end of every build. It records the cell size, the time step range, and per table
+ * the bounding box from its header, the entry and trajectory ID counts, the file size and a
+ * CRC32 of the file contents. Sets built from shards also record every shard they were
+ * built from (name, time step range, size and modification time), so incremental builds can
+ * tell new and changed shards from unchanged ones.
+ *
+ * Tables of one set can have different bounding boxes (see the streaming build), so the
+ * per-table boxes are authoritative; the set-level box is only their union.
+ *
+ * With the manifest, the tables of a range can be checked without opening them and loaded
+ * tables can be validated against the recorded counts and boxes.
+ */
+class SPATIALHASHEDTRAJECTORY_API FSpatialHashManifest
+{
+public:
+	/** Magic number for file identification: 0x4D485354 ("TSHM") */
+	static constexpr uint32 Magic = 0x4D485354;
+
+	/** Current file format version */
+	static constexpr uint32 Version = 3;
+
+	/**
+	 * One hash table file of the set
+	 */
+	struct FTable
+	{
+		/** Time step the table represents */
+		int32 TimeStep = 0;
+
+		/** Number of entries (occupied cells) */
+		uint32 NumEntries = 0;
+
+		/** Number of trajectory IDs */
+		uint32 NumTrajectoryIds = 0;
+
+		/** File size in bytes */
+		int64 FileSize = 0;
+
+		/** CRC32 of the whole file */
+		uint32 Checksum = 0;
+
+		/** Bounding box minimum from the table's header */
+		FVector BBoxMin = FVector::ZeroVector;
+
+		/** Bounding box maximum from the table's header */
+		FVector BBoxMax = FVector::ZeroVector;
+
+		/**
+		 * Fill time step, counts and bounding box from a table header (file size and checksum are left alone)
+		 * @param Header Header of the table
+		 */
+		void SetFromHeader(const FSpatialHashHeader& Header);
+
+		friend FArchive& operator<<(FArchive& Ar, FTable& Table)
+		{
+			Ar << Table.TimeStep << Table.NumEntries << Table.NumTrajectoryIds << Table.FileSize << Table.Checksum;
+			Ar << Table.BBoxMin << Table.BBoxMax;
+			return Ar;
+		}
+	};
+
+	/**
+	 * One shard the tables were built from
+	 */
+	struct FShard
+	{
+		/** Shard file name without directory */
+		FString FileName;
+
+		/** First time step of the shard */
+		int32 StartTimeStep = 0;
+
+		/** Number of time steps in the shard */
+		int32 NumTimeSteps = 0;
+
+		/** File size in bytes when the shard was read */
+		int64 FileSize = 0;
+
+		/** Modification time when the shard was read */
+		FDateTime TimeStamp;
+
+		friend FArchive& operator<<(FArchive& Ar, FShard& Shard)
+		{
+			Ar << Shard.FileName << Shard.StartTimeStep << Shard.NumTimeSteps << Shard.FileSize << Shard.TimeStamp;
+			return Ar;
+		}
+	};
+
+	/** Cell size of the tables */
+	float CellSize = 0.0f;
+
+	/** Minimum of the union of all table bounding boxes (computed by Finalize()) */
+	FVector BBoxMin = FVector::ZeroVector;
+
+	/** Maximum of the union of all table bounding boxes (computed by Finalize()) */
+	FVector BBoxMax = FVector::ZeroVector;
+
+	/**
+	 * Get the path of the manifest file for a cell size
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param CellSize Cell size of the table set
+	 * @return Path to the manifest inside the cellsize directory
+	 */
+	static FString GetManifestFilename(const FString& DatasetDirectory, float CellSize);
+
+	/**
+	 * Compute the CRC32 of a file's contents
+	 * @param Filename Path to the file
+	 * @param OutChecksum Output checksum
+	 * @return true if the file could be read
+	 */
+	static bool ComputeFileChecksum(const FString& Filename, uint32& OutChecksum);
+
+	/** Remove all tables */
+	void Reset();
+
+	/**
+	 * Record a table (replaces an earlier record of the same time step after Finalize())
+	 * @param Table Table record
+	 */
+	void AddTable(const FTable& Table);
+
+	/**
+	 * Remove the records of a time step range (the table files are left alone)
+	 * @param StartTimeStep First time step (inclusive)
+	 * @param EndTimeStep Last time step (inclusive)
+	 */
+	void RemoveTables(int32 StartTimeStep, int32 EndTimeStep);
+
+	/**
+	 * Record a shard (replaces an earlier record of the same file name)
+	 * @param Shard Shard record
+	 */
+	void AddShard(const FShard& Shard);
+
+	/**
+	 * Remove the record of a shard
+	 * @param FileName Shard file name without directory
+	 */
+	void RemoveShard(const FString& FileName);
+
+	/**
+	 * Find the record of a shard
+	 * @param FileName Shard file name without directory
+	 * @return Shard record, or nullptr if the tables were not built from the shard
+	 */
+	const FShard* FindShard(const FString& FileName) const;
+
+	/** @return All shard records */
+	const TArray<FShard>& GetShards() const { return Shards; }
+
+	/** Sort tables by time step, drop superseded records so they can be looked up, and update the set's bounding box */
+	void Finalize();
+
+	/**
+	 * Find the record of a time step
+	 * @param TimeStep Time step
+	 * @return Table record, or nullptr if the set has no table for the time step
+	 */
+	const FTable* FindTable(int32 TimeStep) const;
+
+	/**
+	 * Check whether the set has a table for every time step of a range
+	 * @param StartTimeStep First time step (inclusive)
+	 * @param EndTimeStep Last time step (inclusive)
+	 * @return true if all tables are recorded
+	 */
+	bool HasAllTables(int32 StartTimeStep, int32 EndTimeStep) const;
+
+	/** @return All table records, sorted by time step */
+	const TArray<FTable>& GetTables() const { return Tables; }
+
+	/** @return First time step with a table (0 if empty) */
+	int32 GetMinTimeStep() const { return Tables.Num() > 0 ? Tables[0].TimeStep : 0; }
+
+	/** @return Last time step with a table (-1 if empty) */
+	int32 GetMaxTimeStep() const { return Tables.Num() > 0 ? Tables.Last().TimeStep : -1; }
+
+	/**
+	 * Recreate the manifest from the table files of a cell size (for sets built without one)
+	 * Reads every table completely to compute its checksum.
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param InCellSize Cell size of the table set
+	 * @return true if at least one table was found
+	 */
+	bool BuildFromTableFiles(const FString& DatasetDirectory, float InCellSize);
+
+	/**
+	 * Check a table file's size and checksum against its record
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param TimeStep Time step of the table
+	 * @return true if the file matches its record
+	 */
+	bool VerifyTableFile(const FString& DatasetDirectory, int32 TimeStep) const;
+
+	/**
+	 * Save the manifest to a binary file
+	 * @param Filename Path to output file
+	 * @return true if successful, false otherwise
+	 */
+	bool SaveToFile(const FString& Filename) const;
+
+	/**
+	 * Load the manifest from a binary file
+	 * @param Filename Path to input file
+	 * @return true if successful, false otherwise
+	 */
+	bool LoadFromFile(const FString& Filename);
+
+private:
+	/** Table records, sorted by time step after Finalize() */
+	TArray<FTable> Tables;
+
+	/** Shard records, empty for sets not built from shards */
+	TArray<FShard> Shards;
+};
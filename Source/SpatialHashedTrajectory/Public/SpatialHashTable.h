@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
 
 /**
  * File header for spatial hash table binary files
@@ -11,10 +12,22 @@
  */
 struct FSpatialHashHeader
 {
+	/** Format version storing 16-byte entry records and the trajectory IDs as a raw uint32 array (still writable for external readers) */
+	static constexpr uint32 VersionRawIds = 1;
+
+	/** Format version storing each cell's trajectory IDs as a compressed block */
+	static constexpr uint32 VersionCompressedIds = 2;
+
+	/** Format version storing entries as separate key and count arrays plus a sampled offset index (written by SaveToFile by default) */
+	static constexpr uint32 VersionCompactEntries = 3;
+
+	/** Default for EntryGroupSize */
+	static constexpr uint32 DefaultEntryGroupSize = 16;
+
 	/** Magic number for file identification: 0x54534854 ("TSHT") */
 	uint32 Magic;
 	
-	/** Format version number (current: 1) */
+	/** Format version number (current: 3) */
 	uint32 Version;
 	
 	/** Time step index this hash table represents */
@@ -47,12 +60,21 @@ struct FSpatialHashHeader
 	/** Total number of trajectory IDs in the trajectory IDs array */
 	uint32 NumTrajectoryIds;
 	
-	/** Reserved bytes for future use (16 bytes) */
-	uint32 Reserved[4];
+	/** Size in bytes of the compressed trajectory ID section (version 2 and later, 0 otherwise) */
+	uint32 CompressedIdBytes;
+	
+	/** Number of entries per sample of the entry offset index (version 3) */
+	uint32 EntryGroupSize;
+	
+	/** Size in bytes of the learned index trailer after the trajectory IDs (version 3, 0 if none) */
+	uint32 LearnedIndexBytes;
+	
+	/** Reserved bytes for future use (4 bytes) */
+	uint32 Reserved[1];
 
 	FSpatialHashHeader()
 		: Magic(0x54534854) // "TSHT"
-		, Version(1)
+		, Version(VersionCompactEntries)
 		, TimeStep(0)
 		, CellSize(1.0f)
 		, BBoxMinX(0.0f)
@@ -63,6 +85,9 @@ struct FSpatialHashHeader
 		, BBoxMaxZ(0.0f)
 		, NumEntries(0)
 		, NumTrajectoryIds(0)
+		, CompressedIdBytes(0)
+		, EntryGroupSize(DefaultEntryGroupSize)
+		, LearnedIndexBytes(0)
 	{
 		FMemory::Memzero(Reserved, sizeof(Reserved));
 	}
@@ -84,7 +109,9 @@ struct FSpatialHashHeader
 static_assert(sizeof(FSpatialHashHeader) == 64, "FSpatialHashHeader must be exactly 64 bytes");
 
 /**
- * Hash table entry representing a single spatial cell
+ * Hash table entry representing a single spatial cell, as stored in version 1 and 2 files
+ * Tables keep entries as separate key and count arrays in memory (see FSpatialHashTable::EntryKeys);
+ * FSpatialHashTable::GetEntries() rebuilds this layout on request.
  * Total size: 16 bytes
  */
 struct FSpatialHashEntry
@@ -92,7 +119,10 @@ struct FSpatialHashEntry
 	/** Z-Order curve key (Morton code) for this cell */
 	uint64 ZOrderKey;
 	
-	/** Start index in the trajectory IDs array */
+	/**
+	 * Start index in the trajectory IDs array (version 1), or byte offset of the cell's block
+	 * in the compressed trajectory ID section (version 2)
+	 */
 	uint32 StartIndex;
 	
 	/** Number of trajectories in this cell */
@@ -122,27 +152,115 @@ struct FSpatialHashEntry
 // Ensure the entry is exactly 16 bytes
 static_assert(sizeof(FSpatialHashEntry) == 16, "FSpatialHashEntry must be exactly 16 bytes");
 
+/**
+ * One linear segment of the learned entry index, as stored in the file trailer
+ * Predicts the entry index of a key as FirstIndex + Slope * (Key - FirstKey).
+ * Total size: 16 bytes
+ */
+struct FSpatialHashLearnedSegment
+{
+	/** Key of the segment's first entry */
+	uint64 FirstKey;
+
+	/** Entries per key unit */
+	float Slope;
+
+	/** Index of the segment's first entry */
+	uint32 FirstIndex;
+};
+
+static_assert(sizeof(FSpatialHashLearnedSegment) == 16, "FSpatialHashLearnedSegment must be exactly 16 bytes");
+
 /**
  * In-memory representation of a spatial hash table for one time step
  * 
  * Note: To optimize memory usage, trajectory IDs are not loaded into memory.
- * Instead, they are read on-demand from disk when queried.
+ * Instead, they are read on-demand from disk when queried, using positional reads on
+ * file handles shared through FSpatialHashFileHandlePool.
+ * 
+ * Entries are kept as a dense array of sorted keys plus a parallel array of counts
+ * (12 bytes per cell instead of 16). Where a cell's trajectory IDs start is not stored
+ * per cell: it is the prefix sum of the counts, sampled every EntryGroupSize cells and
+ * completed from the counts (or, for compressed IDs, by skipping the preceding blocks
+ * of the group).
+ * 
+ * Alternatively the whole file can be memory-mapped (see FLoadOptions::bMemoryMap).
+ * Entries and trajectory IDs are then zero-copy views into the mapping and the OS
+ * page cache decides what stays resident.
+ * 
+ * SaveToFile writes format version 3 by default: every cell's trajectory IDs are sorted, delta
+ * encoded and stored as a variable-byte block (StreamVByte layout: 2-bit length codes,
+ * then 1-4 data bytes per ID). Blocks are decoded when a cell is read, with an SSE4
+ * shuffle decoder where available. Version 1 and 2 files with 16-byte entry records
+ * still load and are converted to the compact entry layout, and SaveToFile can still write
+ * version 1 for readers that only understand the raw layout.
+ * Tables holding their IDs in TrajectoryIds (built tables) always use the raw layout.
  */
 class SPATIALHASHEDTRAJECTORY_API FSpatialHashTable
 {
 public:
+	/**
+	 * Options for loading a hash table from disk
+	 */
+	struct FLoadOptions
+	{
+		/** Memory-map the file instead of copying entries and reading trajectory IDs on demand */
+		bool bMemoryMap;
+
+		/** Build the cache-friendly search index for FindEntry (see BuildSearchIndex) */
+		bool bBuildSearchIndex;
+
+		FLoadOptions()
+			: bMemoryMap(false)
+			, bBuildSearchIndex(false)
+		{
+		}
+	};
+
+	/**
+	 * Reusable working memory for radius queries
+	 * Keep one per thread and pass it to every query; once the arrays have grown to the
+	 * working-set size, queries no longer allocate.
+	 */
+	struct FQueryScratch
+	{
+		/** Indices of the occupied cells touched by the query */
+		TArray<int32> EntryIndices;
+
+		/** Buffer for coalesced on-demand reads of trajectory IDs */
+		TArray<uint32> RangeBuffer;
+
+		/** Buffer for coalesced on-demand reads of compressed trajectory ID blocks */
+		TArray<uint8> BlockBuffer;
+	};
+
 	/** Header information */
 	FSpatialHashHeader Header;
 	
-	/** Sorted array of hash table entries */
-	TArray<FSpatialHashEntry> Entries;
+	/** Sorted Z-Order keys of the occupied cells (empty when memory-mapped, use GetEntryKeys() for reading) */
+	TArray<uint64> EntryKeys;
 	
-	/** Array of trajectory IDs, grouped by cell (used for building/saving only) */
+	/** Number of trajectories per occupied cell, parallel to EntryKeys (use GetEntryCounts() for reading) */
+	TArray<uint32> EntryCounts;
+	
+	/** Array of trajectory IDs, grouped by cell in entry order (used for building/saving only) */
 	TArray<uint32> TrajectoryIds;
 	
 	/** Path to the source file for on-demand trajectory ID loading */
 	FString SourceFilePath;
 
+	/** Default maximum prediction error of the learned index (in entries) */
+	static constexpr uint32 DefaultLearnedIndexMaxError = 16;
+
+	/** Default for ReadCoalesceGap (in trajectory IDs, 4 KB) */
+	static constexpr uint32 DefaultReadCoalesceGap = 1024;
+
+	/**
+	 * Maximum number of unused trajectory IDs between two cells that are still read
+	 * as one sequential range during multi-cell queries (on-demand mode only)
+	 */
+	uint32 ReadCoalesceGap = DefaultReadCoalesceGap;
+
 	FSpatialHashTable() = default;
 
 	/**
@@ -154,6 +272,25 @@ public:
 	 */
 	static uint64 CalculateZOrderKey(int32 CellX, int32 CellY, int32 CellZ);
 
+	/**
+	 * Recover 3D cell coordinates from a Z-Order key (inverse of CalculateZOrderKey)
+	 * @param Key Z-Order key
+	 * @param OutCellX Output X cell coordinate
+	 * @param OutCellY Output Y cell coordinate
+	 * @param OutCellZ Output Z cell coordinate
+	 */
+	static void DecodeZOrderKey(uint64 Key, int32& OutCellX, int32& OutCellY, int32& OutCellZ);
+
+	/**
+	 * Compute BIGMIN: the smallest Z-Order key greater than Key that lies inside the cell box
+	 * spanned by MinKey and MaxKey (Tropf & Herzog). Used to skip key runs outside a query box.
+	 * @param Key Z-Order key outside the box, with MinKey < Key < MaxKey
+	 * @param MinKey Z-Order key of the box's minimum corner
+	 * @param MaxKey Z-Order key of the box's maximum corner
+	 * @return Next Z-Order key inside the box
+	 */
+	static uint64 ComputeBigMin(uint64 Key, uint64 MinKey, uint64 MaxKey);
+
 	/**
 	 * Convert world position to cell coordinates
 	 * @param WorldPos World space position
@@ -172,12 +309,188 @@ public:
 		int32& OutCellZ);
 
 	/**
-	 * Find hash entry by Z-Order key using binary search
+	 * Convert many world positions (structure of arrays) to cell coordinates at once
+	 * Same results as WorldToCellCoordinates, vectorized with AVX/SSE4.1 where available.
+	 * @param PosX X coordinates of the positions
+	 * @param PosY Y coordinates of the positions (same length as PosX)
+	 * @param PosZ Z coordinates of the positions (same length as PosX)
+	 * @param BBoxMin Bounding box minimum
+	 * @param CellSize Cell size in world units
+	 * @param OutCellX Output X cell coordinates (at least PosX.Num() elements)
+	 * @param OutCellY Output Y cell coordinates (at least PosX.Num() elements)
+	 * @param OutCellZ Output Z cell coordinates (at least PosX.Num() elements)
+	 */
+	static void WorldToCellCoordinatesBatch(
+		TArrayView<const FVector::FReal> PosX,
+		TArrayView<const FVector::FReal> PosY,
+		TArrayView<const FVector::FReal> PosZ,
+		const FVector& BBoxMin,
+		float CellSize,
+		TArrayView<int32> OutCellX,
+		TArrayView<int32> OutCellY,
+		TArrayView<int32> OutCellZ);
+
+	/**
+	 * Calculate Z-Order keys for many cells at once
+	 * Same results as CalculateZOrderKey, using BMI2 (PDEP) on CPUs where it is fast, else AVX2 where available.
+	 * @param CellX X cell coordinates
+	 * @param CellY Y cell coordinates (same length as CellX)
+	 * @param CellZ Z cell coordinates (same length as CellX)
+	 * @param OutKeys Output Z-Order keys (at least CellX.Num() elements)
+	 */
+	static void CalculateZOrderKeysBatch(
+		TArrayView<const int32> CellX,
+		TArrayView<const int32> CellY,
+		TArrayView<const int32> CellZ,
+		TArrayView<uint64> OutKeys);
+
+	/**
+	 * Recover cell coordinates from many Z-Order keys at once
+	 * Same results as DecodeZOrderKey, using BMI2 (PEXT) on CPUs where it is fast, else AVX2 where available.
+	 * @param Keys Z-Order keys
+	 * @param OutCellX Output X cell coordinates (at least Keys.Num() elements)
+	 * @param OutCellY Output Y cell coordinates (at least Keys.Num() elements)
+	 * @param OutCellZ Output Z cell coordinates (at least Keys.Num() elements)
+	 */
+	static void DecodeZOrderKeysBatch(
+		TArrayView<const uint64> Keys,
+		TArrayView<int32> OutCellX,
+		TArrayView<int32> OutCellY,
+		TArrayView<int32> OutCellZ);
+
+	/**
+	 * Finish a table built in memory from EntryKeys, EntryCounts and TrajectoryIds
+	 * Sets the header counts and the sampled offset index; call after filling the arrays.
+	 */
+	void FinalizeEntries();
+
+	/**
+	 * Find hash entry by Z-Order key
+	 * Uses the hash index if enabled, else the search index if one was built, else the
+	 * learned index if the table has one, otherwise binary search over the sorted keys.
 	 * @param Key Z-Order key to search for
 	 * @return Index of entry if found, -1 otherwise
 	 */
 	int32 FindEntry(uint64 Key) const;
 
+	/**
+	 * Build an in-memory search index over the entry keys for FindEntry
+	 * Keys are stored in Eytzinger (breadth-first) order with their entry indices, so a
+	 * lookup descends an implicit binary tree whose top levels share a few cache lines,
+	 * and the nodes four levels down are prefetched while the current one is compared.
+	 * Costs 12 bytes per entry. Call again after the entries change.
+	 */
+	void BuildSearchIndex();
+
+	/** Release the search index */
+	void ResetSearchIndex();
+
+	/** @return true if FindEntry uses the search index */
+	bool HasSearchIndex() const { return SearchKeys.Num() > 0; }
+
+	/**
+	 * Enable or disable the open-addressing hash index for FindEntry
+	 * The index maps every entry key to its entry index with Robin Hood linear probing, so
+	 * exact-key lookups take O(1) probes instead of O(log N). It is built here when enabled,
+	 * and again whenever the entries change, and is kept at most 2/3 full with 16-byte slots
+	 * (24-48 bytes per entry). Disabling releases it. Range scans keep using the sorted keys.
+	 * Not safe to call while other threads query this table.
+	 * @param bEnable True to look up keys through the hash index
+	 */
+	void SetUseHashIndex(bool bEnable);
+
+	/** @return true if FindEntry uses the hash index */
+	bool IsUsingHashIndex() const { return bUseHashIndex; }
+
+	/**
+	 * Fit the learned index over the entry keys
+	 * Z-Order keys of a time step grow smoothly with their entry index, so a few linear
+	 * segments (16 bytes each) predict the index of any key within MaxError entries, and
+	 * FindEntry only searches that window. Segments are fitted in one pass (shrinking cone)
+	 * and saved with the table, so loading needs no refit. Dropped when the entries change.
+	 * @param MaxError Target maximum prediction error in entries (at least 1)
+	 */
+	void BuildLearnedIndex(uint32 MaxError = DefaultLearnedIndexMaxError);
+
+	/** @return true if FindEntry can use the learned index */
+	bool HasLearnedIndex() const { return LearnedSegments.Num() > 0; }
+
+	/** @return Maximum prediction error of the learned index in entries (0 without learned index) */
+	uint32 GetLearnedIndexMaxError() const { return LearnedMaxError; }
+
+	/**
+	 * Find all occupied cells inside an axis-aligned box of cells (bounds inclusive)
+	 * The box is decomposed into contiguous Z-Order key intervals (BIGMIN) that are scanned
+	 * linearly over the sorted entries, so the cost scales with the number of occupied
+	 * cells rather than with the volume of the box. Coordinates are clamped to the valid range.
+	 * @param MinCell Minimum cell coordinates of the box
+	 * @param MaxCell Maximum cell coordinates of the box
+	 * @param OutEntryIndices Output indices of matching entries, in Z-Order
+	 * @return Number of matching entries
+	 */
+	int32 FindEntriesInCellBox(const FIntVector& MinCell, const FIntVector& MaxCell, TArray<int32>& OutEntryIndices) const;
+
+	/**
+	 * Find all occupied cells whose bounds intersect a query sphere
+	 * Only the cells overlapping the sphere's bounding box are scanned, and cells whose
+	 * closest point is farther than Radius from WorldPos are skipped.
+	 * @param WorldPos Center of the query sphere
+	 * @param Radius Search radius in world units
+	 * @param OutEntryIndices Output indices of matching entries, in Z-Order
+	 * @return Number of matching entries
+	 */
+	int32 FindEntriesInRadius(const FVector& WorldPos, float Radius, TArray<int32>& OutEntryIndices) const;
+
+	/**
+	 * Get the sorted Z-Order keys of all entries, regardless of whether they are owned or memory-mapped
+	 * @return View of all keys
+	 */
+	TArrayView<const uint64> GetEntryKeys() const;
+
+	/**
+	 * Get the trajectory counts of all entries, regardless of whether they are owned or memory-mapped
+	 * @return View of all counts, parallel to GetEntryKeys()
+	 */
+	TArrayView<const uint32> GetEntryCounts() const;
+
+	/** @return Number of entries (occupied cells) */
+	int32 GetNumEntries() const { return GetEntryKeys().Num(); }
+
+	/**
+	 * Get all entries in the version 1 record layout, for callers written against the former Entries array
+	 * StartIndex is the cell's first position in the trajectory IDs concatenated in entry order
+	 * (as returned by GetTrajectoryIdsForEntryRange), whatever the on-disk layout.
+	 * @return Copy of all entries; prefer GetEntryKeys()/GetEntryCounts() which do not allocate
+	 */
+	TArray<FSpatialHashEntry> GetEntries() const;
+
+	/** @return Heap memory in bytes held for the entries and their search index (memory-mapped version 3 files hold none) */
+	int64 GetEntryMemoryBytes() const;
+
+	/**
+	 * Get trajectory IDs for a specific cell without copying
+	 * Only available when trajectory IDs are resident and uncompressed (populated for building,
+	 * or a memory-mapped version 1 file).
+	 * @param EntryIndex Index of the hash table entry
+	 * @return View of the cell's trajectory IDs, empty if not resident or the index is invalid
+	 */
+	TArrayView<const uint32> GetTrajectoryIdsViewForCell(int32 EntryIndex) const;
+
+	/**
+	 * Check whether trajectory IDs can be accessed without reading from disk
+	 * @return true if trajectory IDs are populated or memory-mapped
+	 */
+	bool HasResidentTrajectoryIds() const;
+
+	/** @return true if this table is backed by a memory-mapped file */
+	bool IsMemoryMapped() const { return MappedRegion.IsValid(); }
+
+	/** @return true if trajectory IDs are accessed as compressed blocks (loaded from a version 2 or later file) */
+	bool HasCompressedTrajectoryIds() const
+	{
+		return TrajectoryIds.Num() == 0 && Header.Version >= FSpatialHashHeader::VersionCompressedIds;
+	}
+
 	/**
 	 * Get trajectory IDs for a specific cell (reads from disk on-demand)
 	 * @param EntryIndex Index of the hash table entry
@@ -186,6 +499,16 @@ public:
 	 */
 	bool GetTrajectoryIdsForCell(int32 EntryIndex, TArray<uint32>& OutTrajectoryIds) const;
 
+	/**
+	 * Get trajectory IDs of consecutive cells, concatenated in entry order (reads from disk on-demand)
+	 * Compressed blocks are decoded in one forward walk, so every entry group is read and decoded once.
+	 * @param FirstEntry Index of the first hash table entry
+	 * @param NumEntries Number of entries
+	 * @param OutTrajectoryIds Output array of trajectory IDs
+	 * @return true if successful, false otherwise
+	 */
+	bool GetTrajectoryIdsForEntryRange(int32 FirstEntry, int32 NumEntries, TArray<uint32>& OutTrajectoryIds) const;
+
 	/**
 	 * Query trajectory IDs at a specific world position (reads from disk on-demand)
 	 * @param WorldPos World space position
@@ -196,8 +519,8 @@ public:
 
 	/**
 	 * Query trajectory IDs within a radius around a world position
-	 * This gathers all possible trajectory IDs from cells that overlap with the query radius.
-	 * Does NOT perform actual distance calculations - returns all trajectories in overlapping cells.
+	 * This gathers all possible trajectory IDs from cells that intersect the query sphere.
+	 * Does NOT perform per-trajectory distance calculations - returns all trajectories in intersecting cells.
 	 * 
 	 * @param WorldPos Center of the query sphere
 	 * @param Radius Search radius in world units
@@ -206,19 +529,50 @@ public:
 	 */
 	int32 QueryTrajectoryIdsInRadius(const FVector& WorldPos, float Radius, TArray<uint32>& OutTrajectoryIds) const;
 
+	/**
+	 * Query trajectory IDs within a radius around a world position using caller-supplied working memory
+	 * Candidates are appended straight into OutTrajectoryIds and deduplicated with sort+unique,
+	 * so with a reused output array and scratch the query does not touch the heap.
+	 * 
+	 * @param WorldPos Center of the query sphere
+	 * @param Radius Search radius in world units
+	 * @param OutTrajectoryIds Output array of unique trajectory IDs, sorted ascending
+	 * @param Scratch Working memory reused across queries
+	 * @return Number of trajectories found
+	 */
+	int32 QueryTrajectoryIdsInRadius(const FVector& WorldPos, float Radius, TArray<uint32>& OutTrajectoryIds, FQueryScratch& Scratch) const;
+
 	/**
 	 * Save hash table to binary file
+	 * Format version 3 holds key and count arrays, a sampled offset index, trajectory IDs
+	 * compressed per cell and an optional learned index trailer. Format version 1 holds
+	 * 16-byte entry records and the raw trajectory IDs (4 bytes each, no learned index),
+	 * for external readers of the original layout.
+	 * Only valid while trajectory IDs are owned (i.e. for built tables).
 	 * @param Filename Path to output file
+	 * @param OutChecksum Optional output CRC32 of the written file
+	 * @param OutFileSize Optional output size in bytes of the written file
+	 * @param FileVersion Format version to write: FSpatialHashHeader::VersionCompactEntries or VersionRawIds
 	 * @return true if successful, false otherwise
 	 */
-	bool SaveToFile(const FString& Filename) const;
+	bool SaveToFile(const FString& Filename, uint32* OutChecksum = nullptr, int64* OutFileSize = nullptr,
+		uint32 FileVersion = FSpatialHashHeader::VersionCompactEntries) const;
 
 	/**
 	 * Load hash table from binary file (trajectory IDs not loaded into memory)
 	 * @param Filename Path to input file
+	 * @param Options Load options (e.g. memory-mapped mode)
 	 * @return true if successful, false otherwise
 	 */
-	bool LoadFromFile(const FString& Filename);
+	bool LoadFromFile(const FString& Filename, const FLoadOptions& Options = FLoadOptions());
+
+	/**
+	 * Read only the header of a hash table file
+	 * @param Filename Path to input file
+	 * @param OutHeader Output header
+	 * @return true if the file has a valid header, false otherwise
+	 */
+	static bool LoadHeaderFromFile(const FString& Filename, FSpatialHashHeader& OutHeader);
 
 	/**
 	 * Validate the hash table structure
@@ -235,4 +589,172 @@ private:
 	 * @return true if successful, false otherwise
 	 */
 	bool ReadTrajectoryIdsFromDisk(uint32 StartIndex, uint32 Count, TArray<uint32>& OutTrajectoryIds) const;
+
+	/**
+	 * Read a byte range of the compressed trajectory ID section from disk
+	 * @param ByteOffset Offset in the compressed section
+	 * @param NumBytes Number of bytes to read
+	 * @param OutBytes Output bytes
+	 * @return true if successful, false otherwise
+	 */
+	bool ReadIdBlocksFromDisk(uint32 ByteOffset, uint32 NumBytes, TArray<uint8>& OutBytes) const;
+
+	/** @return Sampled offset index: offset of every EntryGroupSize-th cell's IDs, plus the end of the ID section */
+	TArrayView<const uint32> GetEntryGroupOffsets() const;
+
+	/**
+	 * Get the index of a cell's first trajectory ID (raw ID layout)
+	 * @param EntryIndex Index of the hash table entry
+	 * @return Index into the trajectory IDs array
+	 */
+	uint32 GetRawIdStart(int32 EntryIndex) const;
+
+	/**
+	 * Decode the compressed blocks of several cells from a buffer holding whole entry groups
+	 * @param SortedEntryIndices Indices of the cells, ascending
+	 * @param Blocks Buffer holding part of the compressed trajectory ID section
+	 * @param BlocksOffset Byte offset of the buffer in the compressed section
+	 * @param NumBytes Size of the buffer in bytes
+	 * @param OutTrajectoryIds Array the decoded IDs are appended to
+	 * @return true if successful, false if a block is truncated
+	 */
+	bool DecodeIdBlocksForEntries(TArrayView<const int32> SortedEntryIndices, const uint8* Blocks, uint64 BlocksOffset,
+		int64 NumBytes, TArray<uint32>& OutTrajectoryIds) const;
+
+	/**
+	 * Compress the trajectory IDs into per-cell blocks as stored in version 2 and later files
+	 * @param OutGroupOffsets Output byte offset of every EntryGroupSize-th cell's block, plus the section size
+	 * @param OutBlocks Output compressed trajectory ID section
+	 * @return true if successful, false if the section exceeds the format's 4 GB limit
+	 */
+	bool EncodeTrajectoryIdBlocks(TArray<uint32>& OutGroupOffsets, TArray64<uint8>& OutBlocks) const;
+
+	/**
+	 * Take over the 16-byte entry records of a version 1 or 2 file in the compact layout
+	 * @param Records Entry records in file order
+	 */
+	void SetEntriesFromRecords(TArrayView<const FSpatialHashEntry> Records);
+
+	/**
+	 * Get trajectory IDs for several cells at once
+	 * In on-demand mode the cells are sorted by position in the file and nearby ranges are merged
+	 * (see ReadCoalesceGap), so many cells cost a few large sequential reads.
+	 * @param EntryIndices Indices of the hash table entries (reordered by this call)
+	 * @param OutTrajectoryIds Output array of trajectory IDs of all cells (may contain duplicates)
+	 * @param Scratch Reusable buffers for the merged disk reads
+	 * @return true if successful, false otherwise
+	 */
+	bool GatherTrajectoryIdsForEntries(TArray<int32>& EntryIndices, TArray<uint32>& OutTrajectoryIds, FQueryScratch& Scratch) const;
+
+	/**
+	 * Memory-map a hash table file and point the entry/trajectory ID views into it
+	 * @param Filename Path to input file
+	 * @return true if the file was mapped and its header is valid, false otherwise
+	 */
+	bool MapFile(const FString& Filename);
+
+	/** Release the file mapping (if any) and clear the mapped views */
+	void UnmapFile();
+
+	/** Mapped file handle (must outlive MappedRegion, so it is declared first) */
+	TSharedPtr<IMappedFileHandle> MappedFile;
+
+	/** Mapped region covering the whole file */
+	TSharedPtr<IMappedFileRegion> MappedRegion;
+
+	/** Offset of every EntryGroupSize-th cell's IDs plus the end of the ID section (owned) */
+	TArray<uint32> EntryGroupOffsets;
+
+	/** Entry keys inside the mapped region (version 3 files) */
+	TArrayView<const uint64> MappedEntryKeys;
+
+	/** Entry counts inside the mapped region (version 3 files) */
+	TArrayView<const uint32> MappedEntryCounts;
+
+	/** Sampled offset index inside the mapped region (version 3 files) */
+	TArrayView<const uint32> MappedEntryGroupOffsets;
+
+	/** Trajectory IDs inside the mapped region (version 1 files) */
+	TArrayView<const uint32> MappedTrajectoryIds;
+
+	/** Compressed trajectory ID section inside the mapped region (version 2 and later files) */
+	TArrayView64<const uint8> MappedIdBlocks;
+
+	/** Entry keys in Eytzinger order, 1-based (element 0 is padding); empty without search index */
+	TArray<uint64, TAlignedHeapAllocator<64>> SearchKeys;
+
+	/** Entry index of each element of SearchKeys */
+	TArray<int32> SearchEntryIndices;
+
+	/** Release the learned index */
+	void ResetLearnedIndex();
+
+	/**
+	 * Bucket the learned segments by the top bits of (Key - first key) for FindEntry
+	 * Call after LearnedSegments is set.
+	 */
+	void BuildLearnedRadixTable();
+
+	/**
+	 * Find an entry through the learned index
+	 * @param Key Z-Order key to search for
+	 * @return Index of entry if found, -1 otherwise
+	 */
+	int32 FindEntryLearned(uint64 Key) const;
+
+	/**
+	 * Serialize the learned index as stored in the file trailer
+	 * @param OutBytes Output trailer: max error, segment count, then the segments
+	 */
+	void WriteLearnedIndex(TArray<uint8>& OutBytes) const;
+
+	/**
+	 * Restore the learned index from a file trailer
+	 * @param Bytes Trailer data
+	 * @param NumBytes Size of the trailer
+	 * @return true if the trailer is well-formed
+	 */
+	bool ReadLearnedIndex(const uint8* Bytes, int64 NumBytes);
+
+	/** Learned index segments, sorted by key; empty without learned index */
+	TArray<FSpatialHashLearnedSegment> LearnedSegments;
+
+	/** Maximum distance of a predicted entry index from the true one */
+	uint32 LearnedMaxError = 0;
+
+	/** First segment of each key bucket, plus the segment count */
+	TArray<uint32> LearnedRadixTable;
+
+	/** Right shift turning (Key - first key) into a bucket of LearnedRadixTable */
+	uint32 LearnedRadixShift = 0;
+
+	/**
+	 * One slot of the hash index
+	 */
+	struct FHashIndexSlot
+	{
+		/** Z-Order key of the entry */
+		uint64 Key;
+
+		/** Entry index, INDEX_NONE for an empty slot */
+		int32 EntryIndex;
+
+		/** Distance of the slot from the key's home slot */
+		uint32 ProbeDistance;
+	};
+
+	/** Fill HashIndexSlots from the entry keys */
+	void BuildHashIndex();
+
+	/** Release the hash index slots */
+	void ResetHashIndex();
+
+	/** Whether FindEntry uses the hash index */
+	bool bUseHashIndex = false;
+
+	/** Hash index slots, a power of two of them, empty while the hash index is disabled */
+	TArray<FHashIndexSlot> HashIndexSlots;
+
+	/** Right shift turning the 64-bit key hash into a slot index */
+	uint32 HashIndexShift = 64;
 };
@@ -22,6 +22,9 @@ public:
 		/** Cell size in world units (uniform in all dimensions) */
 		float CellSize;
 
+		/** Cell sizes to build in one pass over the data (if empty, only CellSize is built) */
+		TArray<float> CellSizes;
+
 		/** Bounding box minimum (if not provided, will be computed from data) */
 		FVector BBoxMin;
 
@@ -43,6 +46,18 @@ public:
 		/** Starting timestep number (offset for file naming) - used when array index 0 corresponds to a different timestep number */
 		uint32 StartTimeStep;
 
+		/** Default memory budget: 4 GB */
+		static constexpr int64 DefaultMemoryBudgetBytes = 4ll * 1024 * 1024 * 1024;
+
+		/** Memory budget in bytes for shard data, samples and unwritten tables held by a streaming build */
+		int64 MemoryBudgetBytes;
+
+		/** Maximum prediction error of the learned index saved with each table (0 = no learned index) */
+		uint32 LearnedIndexMaxError;
+
+		/** Format version of the written tables (FSpatialHashHeader::VersionRawIds for readers of the original layout, which has no learned index) */
+		uint32 FileVersion;
+
 		FBuildConfig()
 			: CellSize(10.0f)
 			, BBoxMin(FVector::ZeroVector)
@@ -52,7 +67,16 @@ public:
 			, OutputDirectory(TEXT(""))
 			, NumTimeSteps(0)
 			, StartTimeStep(0)
+			, MemoryBudgetBytes(DefaultMemoryBudgetBytes)
+			, LearnedIndexMaxError(0)
+			, FileVersion(FSpatialHashHeader::VersionCompactEntries)
+		{
+		}
+
+		/** @return Cell sizes to build: CellSizes if set, otherwise CellSize */
+		TArray<float> GetCellSizes() const
 		{
+			return CellSizes.Num() > 0 ? CellSizes : TArray<float>({ CellSize });
 		}
 	};
 
@@ -84,6 +108,7 @@ public:
 
 	/**
 	 * Build spatial hash tables from trajectory data
+	 * One set of tables is built for every cell size in Config.GetCellSizes().
 	 * 
 	 * @param Config Build configuration
 	 * @param TimeStepSamples Array of trajectory samples for each time step
@@ -109,6 +134,50 @@ public:
 		const FBuildConfig& Config,
 		FSpatialHashTable& OutHashTable);
 
+	/**
+	 * Derive a coarser level from an existing hash table without reading trajectories
+	 * With the same bounding box minimum, a cell of 2^NumLevels times the cell size contains
+	 * exactly the fine cells whose coordinates agree after a right shift by NumLevels, i.e.
+	 * whose Z-Order keys agree after a right shift by 3 * NumLevels. The fine entries are
+	 * sorted by key, so every coarse cell is one run of fine entries that is merged in a
+	 * single linear pass.
+	 * 
+	 * Fine cells are stored in key order, so the coarse table's trajectory IDs are the fine
+	 * IDs in the same order; they are fetched in one pass (each compressed group is decoded once).
+	 * 
+	 * @param FineTable Source table (trajectory IDs are read from disk if not resident)
+	 * @param NumLevels Number of levels to go up (1 = 2x, 2 = 4x, 3 = 8x cell size)
+	 * @param OutCoarseTable Output table with cell size FineTable.Header.CellSize * 2^NumLevels
+	 * @param LearnedIndexMaxError Max error of the coarse table's learned index if the fine table
+	 *                             has one (0 = the fine table's max error)
+	 * @return true if successful, false otherwise
+	 */
+	static bool BuildCoarserLevel(
+		const FSpatialHashTable& FineTable,
+		int32 NumLevels,
+		FSpatialHashTable& OutCoarseTable,
+		uint32 LearnedIndexMaxError = 0);
+
+	/**
+	 * Derive coarser levels for every table of an existing cell size
+	 * For each spatial_hashing/cellsize_<FineCellSize>/timestep_*.bin, writes tables with
+	 * 2x, 4x, ... 2^NumLevels times the cell size into their own cellsize directories.
+	 * 
+	 * @param OutputDirectory Base directory containing the spatial_hashing directory
+	 * @param FineCellSize Cell size of the existing table set
+	 * @param NumLevels Number of coarser levels to produce
+	 * @param LearnedIndexMaxError Max error of the coarse learned indices (0 = each fine table's max error)
+	 * @return true if all levels were written for all time steps
+	 */
+	static bool BuildCoarserLevelsFromFiles(
+		const FString& OutputDirectory,
+		float FineCellSize,
+		int32 NumLevels = 3,
+		uint32 LearnedIndexMaxError = 0);
+
+	/** Maximum number of coarser levels (keys hold 21 bits per axis) */
+	static constexpr int32 MaxCoarserLevels = 20;
+
 	/**
 	 * Compute bounding box from trajectory samples
 	 * 
@@ -149,19 +218,22 @@ public:
 
 private:
 	/**
-	 * Helper structure for building hash tables
+	 * Trajectory sample reduced to the Z-Order key of its cell
 	 */
-	struct FCellData
+	struct FCellSample
 	{
-		/** Z-Order key for this cell */
+		/** Z-Order key of the cell containing the sample */
 		uint64 ZOrderKey;
 
-		/** Trajectory IDs in this cell */
-		TArray<uint32> TrajectoryIds;
-
-		FCellData(uint64 InKey)
-			: ZOrderKey(InKey)
-		{
-		}
+		/** Trajectory ID of the sample */
+		uint32 TrajectoryId;
 	};
+
+	/**
+	 * Sort cell samples by Z-Order key (stable LSD radix sort)
+	 * Samples with equal keys keep their relative order.
+	 * 
+	 * @param CellSamples Samples to sort in place
+	 */
+	static void SortCellSamplesByKey(TArray<FCellSample>& CellSamples);
 };
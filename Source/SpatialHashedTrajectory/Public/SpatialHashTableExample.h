@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "SpatialHashTable.h"
 #include "SpatialHashTableBuilder.h"
+#include "Algo/Unique.h"
 
 /**
  * Example usage and validation functions for spatial hash tables
@@ -29,26 +30,25 @@ namespace SpatialHashTableExample
 
 		// Create some test entries
 		// Cell (0, 0, 0) with trajectory IDs 1, 2
-		OutHashTable.Entries.Add(FSpatialHashEntry(
-			FSpatialHashTable::CalculateZOrderKey(0, 0, 0), 0, 2));
+		OutHashTable.EntryKeys.Add(FSpatialHashTable::CalculateZOrderKey(0, 0, 0));
+		OutHashTable.EntryCounts.Add(2);
 		OutHashTable.TrajectoryIds.Add(1);
 		OutHashTable.TrajectoryIds.Add(2);
 
 		// Cell (1, 0, 0) with trajectory ID 3
-		OutHashTable.Entries.Add(FSpatialHashEntry(
-			FSpatialHashTable::CalculateZOrderKey(1, 0, 0), 2, 1));
+		OutHashTable.EntryKeys.Add(FSpatialHashTable::CalculateZOrderKey(1, 0, 0));
+		OutHashTable.EntryCounts.Add(1);
 		OutHashTable.TrajectoryIds.Add(3);
 
 		// Cell (0, 1, 0) with trajectory IDs 4, 5, 6
-		OutHashTable.Entries.Add(FSpatialHashEntry(
-			FSpatialHashTable::CalculateZOrderKey(0, 1, 0), 3, 3));
+		OutHashTable.EntryKeys.Add(FSpatialHashTable::CalculateZOrderKey(0, 1, 0));
+		OutHashTable.EntryCounts.Add(3);
 		OutHashTable.TrajectoryIds.Add(4);
 		OutHashTable.TrajectoryIds.Add(5);
 		OutHashTable.TrajectoryIds.Add(6);
 
-		// Update header counts
-		OutHashTable.Header.NumEntries = OutHashTable.Entries.Num();
-		OutHashTable.Header.NumTrajectoryIds = OutHashTable.TrajectoryIds.Num();
+		// Sample the cell offsets and update header counts
+		OutHashTable.FinalizeEntries();
 	}
 
 	/**
@@ -161,31 +161,36 @@ namespace SpatialHashTableExample
 		// Verify data matches
 		if (LoadedTable.Header.TimeStep != OriginalTable.Header.TimeStep ||
 			LoadedTable.Header.CellSize != OriginalTable.Header.CellSize ||
-			LoadedTable.Entries.Num() != OriginalTable.Entries.Num() ||
-			LoadedTable.TrajectoryIds.Num() != OriginalTable.TrajectoryIds.Num())
+			LoadedTable.Header.NumTrajectoryIds != OriginalTable.Header.NumTrajectoryIds ||
+			LoadedTable.GetNumEntries() != OriginalTable.GetNumEntries())
 		{
 			UE_LOG(LogTemp, Error, TEXT("Loaded hash table data does not match original"));
 			return false;
 		}
 
-		// Verify entries match
-		for (int32 i = 0; i < OriginalTable.Entries.Num(); ++i)
+		// Verify entries and their trajectory IDs match
+		// (saved files store compressed blocks, so IDs come back sorted per cell)
+		TArray<uint32> OriginalIds;
+		TArray<uint32> LoadedIds;
+		for (int32 i = 0; i < OriginalTable.GetNumEntries(); ++i)
 		{
-			if (LoadedTable.Entries[i].ZOrderKey != OriginalTable.Entries[i].ZOrderKey ||
-				LoadedTable.Entries[i].StartIndex != OriginalTable.Entries[i].StartIndex ||
-				LoadedTable.Entries[i].TrajectoryCount != OriginalTable.Entries[i].TrajectoryCount)
+			if (LoadedTable.GetEntryKeys()[i] != OriginalTable.GetEntryKeys()[i] ||
+				LoadedTable.GetEntryCounts()[i] != OriginalTable.GetEntryCounts()[i])
 			{
 				UE_LOG(LogTemp, Error, TEXT("Entry %d does not match"), i);
 				return false;
 			}
-		}
 
-		// Verify trajectory IDs match
-		for (int32 i = 0; i < OriginalTable.TrajectoryIds.Num(); ++i)
-		{
-			if (LoadedTable.TrajectoryIds[i] != OriginalTable.TrajectoryIds[i])
+			if (!OriginalTable.GetTrajectoryIdsForCell(i, OriginalIds) || !LoadedTable.GetTrajectoryIdsForCell(i, LoadedIds))
 			{
-				UE_LOG(LogTemp, Error, TEXT("Trajectory ID %d does not match"), i);
+				UE_LOG(LogTemp, Error, TEXT("Failed to read trajectory IDs of entry %d"), i);
+				return false;
+			}
+
+			OriginalIds.Sort();
+			if (LoadedIds != OriginalIds)
+			{
+				UE_LOG(LogTemp, Error, TEXT("Trajectory IDs of entry %d do not match"), i);
 				return false;
 			}
 		}
@@ -316,6 +321,106 @@ namespace SpatialHashTableExample
 		return true;
 	}
 
+	/**
+	 * Compare the entry lookup methods on a synthetic hash table
+	 * Times FindEntry with binary search, the search index, the learned index and the hash index on
+	 * NumCells random occupied cells; about half of the looked up keys are occupied.
+	 * Timings and index memory are logged.
+	 * 
+	 * @param NumCells Number of random occupied cells (duplicates are dropped)
+	 * @param NumLookups Number of timed lookups per method
+	 * @return true if all methods found the same entries
+	 */
+	inline bool BenchmarkEntryLookup(int32 NumCells = 1000000, int32 NumLookups = 1000000)
+	{
+		if (NumCells <= 0 || NumLookups <= 0)
+		{
+			return false;
+		}
+
+		FRandomStream Random(12345);
+		auto RandomKey = [&Random]()
+		{
+			return FSpatialHashTable::CalculateZOrderKey(Random.RandRange(0, 1023), Random.RandRange(0, 1023), Random.RandRange(0, 1023));
+		};
+
+		// Sorted unique keys with one trajectory per cell, as the builder would produce them
+		FSpatialHashTable HashTable;
+		for (int32 i = 0; i < NumCells; ++i)
+		{
+			HashTable.EntryKeys.Add(RandomKey());
+		}
+		HashTable.EntryKeys.Sort();
+		HashTable.EntryKeys.SetNum(Algo::Unique(HashTable.EntryKeys));
+		HashTable.EntryCounts.Init(1, HashTable.EntryKeys.Num());
+		for (int32 i = 0; i < HashTable.EntryKeys.Num(); ++i)
+		{
+			HashTable.TrajectoryIds.Add((uint32)i);
+		}
+		HashTable.FinalizeEntries();
+
+		const int32 NumEntries = HashTable.GetNumEntries();
+		TArray<uint64> LookupKeys;
+		LookupKeys.SetNumUninitialized(NumLookups);
+		for (int32 i = 0; i < NumLookups; ++i)
+		{
+			LookupKeys[i] = (i & 1) ? HashTable.EntryKeys[Random.RandRange(0, NumEntries - 1)] : RandomKey();
+		}
+
+		auto RunLookups = [&HashTable, &LookupKeys](TArray<int32>& OutEntryIndices)
+		{
+			OutEntryIndices.SetNumUninitialized(LookupKeys.Num());
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 i = 0; i < LookupKeys.Num(); ++i)
+			{
+				OutEntryIndices[i] = HashTable.FindEntry(LookupKeys[i]);
+			}
+			return FPlatformTime::Seconds() - StartTime;
+		};
+
+		const int64 EntryBytes = HashTable.GetEntryMemoryBytes();
+
+		TArray<int32> BinarySearchResults;
+		const double BinarySearchSeconds = RunLookups(BinarySearchResults);
+
+		HashTable.BuildSearchIndex();
+		const int64 SearchIndexBytes = HashTable.GetEntryMemoryBytes() - EntryBytes;
+		TArray<int32> SearchIndexResults;
+		const double SearchIndexSeconds = RunLookups(SearchIndexResults);
+		HashTable.ResetSearchIndex();
+
+		HashTable.BuildLearnedIndex();
+		const int64 LearnedIndexBytes = HashTable.GetEntryMemoryBytes() - EntryBytes;
+		TArray<int32> LearnedIndexResults;
+		const double LearnedIndexSeconds = RunLookups(LearnedIndexResults);
+
+		// Enabling builds the hash index
+		const double BuildStartTime = FPlatformTime::Seconds();
+		HashTable.SetUseHashIndex(true);
+		const double HashIndexBuildSeconds = FPlatformTime::Seconds() - BuildStartTime;
+		const int64 HashIndexBytes = HashTable.GetEntryMemoryBytes() - EntryBytes - LearnedIndexBytes;
+		TArray<int32> HashIndexResults;
+		const double HashIndexSeconds = RunLookups(HashIndexResults);
+
+		const double NanosecondsPerLookup = 1.0e9 / NumLookups;
+		UE_LOG(LogTemp, Log, TEXT("Entry lookup benchmark: %d cells, %d lookups"), NumEntries, NumLookups);
+		UE_LOG(LogTemp, Log, TEXT("  Binary search: %.1f ns per lookup"), BinarySearchSeconds * NanosecondsPerLookup);
+		UE_LOG(LogTemp, Log, TEXT("  Search index:  %.1f ns per lookup, %.1f extra bytes per cell"),
+			SearchIndexSeconds * NanosecondsPerLookup, (double)SearchIndexBytes / NumEntries);
+		UE_LOG(LogTemp, Log, TEXT("  Learned index: %.1f ns per lookup, %.1f extra bytes per cell"),
+			LearnedIndexSeconds * NanosecondsPerLookup, (double)LearnedIndexBytes / NumEntries);
+		UE_LOG(LogTemp, Log, TEXT("  Hash index:    %.1f ns per lookup, %.1f extra bytes per cell, built in %.1f ms"),
+			HashIndexSeconds * NanosecondsPerLookup, (double)HashIndexBytes / NumEntries, HashIndexBuildSeconds * 1000.0);
+
+		if (SearchIndexResults != BinarySearchResults || LearnedIndexResults != BinarySearchResults || HashIndexResults != BinarySearchResults)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Entry lookup methods returned different entries"));
+			return false;
+		}
+
+		return true;
+	}
+
 	/**
 	 * Run all validation tests
 	 * 
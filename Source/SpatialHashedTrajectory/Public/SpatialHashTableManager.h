@@ -8,6 +8,9 @@
 #include "SpatialHashTableBuilder.h"
 #include "SpatialHashTableManager.generated.h"
 
+class FTrajectoryShardIndex;
+class FSpatialHashManifest;
+
 // Forward declare callback delegate types for async queries (C++ only)
 DECLARE_DELEGATE_OneParam(FOnSpatialHashQueryComplete, const TArray<FSpatialHashQueryResult>&);
 DECLARE_DELEGATE_TwoParams(FOnSpatialHashDualQueryComplete, const TArray<FSpatialHashQueryResult>&, const TArray<FSpatialHashQueryResult>&);
@@ -177,6 +180,7 @@ public:
 	 * @param CellSize Cell size for the hash tables
 	 * @param StartTimeStep First time step to create
 	 * @param EndTimeStep Last time step to create
+	 * @param bForceRebuild Rebuild from all shards even if up-to-date tables exist
 	 * @param OnComplete Delegate called when creation completes (success or failure)
 	 */
 	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
@@ -184,7 +188,64 @@ public:
 		const FString& DatasetDirectory,
 		float CellSize,
 		int32 StartTimeStep,
-		int32 EndTimeStep);
+		int32 EndTimeStep,
+		bool bForceRebuild = false);
+
+	/**
+	 * Create hash tables for several cell sizes asynchronously (non-blocking)
+	 * Like CreateHashTablesAsync, but the shards are read and their samples extracted
+	 * only once, and the tables of all cell sizes are built from the same samples.
+	 * Existing tables are updated incrementally (see TryCreateHashTables) unless bForceRebuild is set.
+	 * 
+	 * @param DatasetDirectory Output directory for hash tables
+	 * @param CellSizes Cell sizes for the hash tables (e.g. 5, 10, 25, 50)
+	 * @param StartTimeStep First time step to create
+	 * @param EndTimeStep Last time step to create
+	 * @param bForceRebuild Rebuild from all shards even if up-to-date tables exist
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void CreateHashTablesForCellSizesAsync(
+		const FString& DatasetDirectory,
+		const TArray<float>& CellSizes,
+		int32 StartTimeStep,
+		int32 EndTimeStep,
+		bool bForceRebuild = false);
+
+	/**
+	 * Derive coarser hash table levels from an existing cell size asynchronously (non-blocking)
+	 * Like CreateCoarserLevels, but the levels are written on a background thread and then
+	 * loaded for the given time step range on the game thread. Shares the in-progress state
+	 * with CreateHashTablesAsync (see IsCreatingHashTables()).
+	 * 
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param FineCellSize Cell size of the existing hash tables
+	 * @param StartTimeStep First time step to load after creation
+	 * @param EndTimeStep Last time step to load after creation
+	 * @param NumLevels Number of coarser levels to create (3 = 2x, 4x and 8x)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void CreateCoarserLevelsAsync(
+		const FString& DatasetDirectory,
+		float FineCellSize,
+		int32 StartTimeStep,
+		int32 EndTimeStep,
+		int32 NumLevels = 3);
+
+	/**
+	 * Derive coarser hash table levels from an existing cell size without reading trajectories
+	 * Writes the levels with 2x, 4x, ... 2^NumLevels times FineCellSize next to the existing
+	 * spatial_hashing/cellsize_X directory (see FSpatialHashTableBuilder::BuildCoarserLevel).
+	 * Blocks until all levels are written; use CreateCoarserLevelsAsync on the game thread.
+	 * 
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param FineCellSize Cell size of the existing hash tables
+	 * @param NumLevels Number of coarser levels to create (3 = 2x, 4x and 8x)
+	 * @return True if all levels were created
+	 */
+	bool CreateCoarserLevels(
+		const FString& DatasetDirectory,
+		float FineCellSize,
+		int32 NumLevels = 3);
 
 	/**
 	 * Check if hash table creation is currently in progress
@@ -249,6 +310,48 @@ public:
 		int32 TimeStep,
 		TArray<FSpatialHashQueryResult>& OutResults);
 
+	/**
+	 * Check every hash table file of a cell size against the sizes and checksums in its manifest
+	 * Reads all tables completely, so this is meant for diagnostics rather than every load.
+	 * 
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param CellSize Cell size of the hash tables
+	 * @return True if a manifest exists and all recorded tables match it
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	bool VerifyHashTables(const FString& DatasetDirectory, float CellSize) const;
+
+	/**
+	 * Pick the loaded hash table level whose cell size best matches a query radius
+	 * Small cells make a query visit many cells, large cells return many candidates
+	 * that fail the distance check; the level with the cell size closest to the
+	 * radius (on a logarithmic scale) balances both.
+	 * 
+	 * @param Radius Search radius in world units
+	 * @param TimeStep Time step to query (only levels loaded for it are considered)
+	 * @return Selected cell size, or 0 if no hash table is loaded for the time step
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	float SelectCellSizeForRadius(float Radius, int32 TimeStep) const;
+
+	/**
+	 * Like QueryRadiusWithDistanceCheck, but uses the level chosen by SelectCellSizeForRadius
+	 * 
+	 * @param DatasetDirectory Path to dataset containing trajectory data
+	 * @param QueryPosition World position to query
+	 * @param Radius Search radius in world units
+	 * @param TimeStep Time step to query
+	 * @param OutResults Array of trajectory query results with sample points
+	 * @return Number of trajectories found
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	int32 QueryRadiusWithDistanceCheckAtBestLevel(
+		const FString& DatasetDirectory,
+		FVector QueryPosition,
+		float Radius,
+		int32 TimeStep,
+		TArray<FSpatialHashQueryResult>& OutResults);
+
 	/**
 	 * Query trajectories with dual radius (inner and outer) for a single point at a single timestep
 	 * Returns two separate arrays: one for inner radius, one for outer radius.
@@ -373,6 +476,102 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
 	void GetMemoryStats(int32& OutTotalHashTables, int64& OutTotalMemoryBytes) const;
 
+	/**
+	 * Set the maximum number of hash table files kept open for on-demand trajectory ID reads
+	 * Files are shared by all loaded hash tables; the least recently used one is closed
+	 * when the limit is reached.
+	 * 
+	 * @param MaxOpenFiles Maximum number of simultaneously open files (at least 1)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void SetMaxOpenFileHandles(int32 MaxOpenFiles);
+
+	/**
+	 * Enable or disable memory-mapped loading for hash tables loaded from now on
+	 * Mapped tables read entries and trajectory IDs directly from the OS page cache
+	 * instead of copying entries into memory and reading trajectory IDs per query.
+	 * Already loaded tables are not affected.
+	 * 
+	 * @param bEnable True to memory-map hash table files
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void SetUseMemoryMappedTables(bool bEnable) { bUseMemoryMappedTables = bEnable; }
+
+	/**
+	 * Check whether hash tables are memory-mapped when loaded
+	 * 
+	 * @return True if memory-mapped loading is enabled
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	bool GetUseMemoryMappedTables() const { return bUseMemoryMappedTables; }
+
+	/**
+	 * Enable or disable the search index for hash tables loaded from now on
+	 * Indexed tables keep a cache-friendly copy of their entry keys (12 bytes per occupied
+	 * cell) that speeds up cell lookups on tables with many occupied cells.
+	 * Already loaded tables are not affected.
+	 * 
+	 * @param bEnable True to build a search index when loading
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void SetUseTableSearchIndex(bool bEnable) { bUseTableSearchIndex = bEnable; }
+
+	/**
+	 * Check whether a search index is built for hash tables when loaded
+	 * 
+	 * @return True if the search index is enabled
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	bool GetUseTableSearchIndex() const { return bUseTableSearchIndex; }
+
+	/**
+	 * Trade memory for lookup speed: enable or disable the hash index of hash tables
+	 * Indexed tables find the cell of an exact key (QueryCell and other point lookups) in
+	 * constant time instead of a binary search, for 24-48 bytes per occupied cell. Enabling
+	 * builds the index of every loaded table, and future tables build theirs when loaded.
+	 * 
+	 * @param bEnable True to use hash indices for cell lookups
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void SetUseTableHashIndex(bool bEnable);
+
+	/**
+	 * Check whether hash tables use a hash index for cell lookups
+	 * 
+	 * @return True if the hash index is enabled
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	bool GetUseTableHashIndex() const { return bUseTableHashIndex; }
+
+	/**
+	 * Set the maximum prediction error of the learned index saved with hash tables built from now on
+	 * A learned index is a few linear segments that predict where a cell's key lies among the
+	 * sorted keys, so lookups only search a small window around the prediction. It is stored
+	 * in the table file (16 bytes per segment) and used by every table loaded from it.
+	 * 
+	 * @param MaxError Maximum error in entries (0 builds tables without learned index)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void SetLearnedIndexMaxError(int32 MaxError) { LearnedIndexMaxError = (uint32)FMath::Max(0, MaxError); }
+
+	/**
+	 * Get the maximum prediction error of the learned index saved with built hash tables
+	 * 
+	 * @return Maximum error in entries (0 if built tables have no learned index)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	int32 GetLearnedIndexMaxError() const { return (int32)LearnedIndexMaxError; }
+
+	/**
+	 * Set the gap threshold for coalescing trajectory ID reads of multi-cell queries
+	 * Cells whose trajectory ID ranges are at most this many IDs apart are fetched with
+	 * one sequential read. Applies to loaded and future hash tables.
+	 * 
+	 * @param GapInTrajectoryIds Maximum gap in trajectory IDs (0 merges only touching ranges)
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Spatial Hash")
+	void SetReadCoalesceGap(int32 GapInTrajectoryIds);
+
 	// ============================================================================
 	// ASYNC QUERY METHODS (Non-blocking with callbacks)
 	// ============================================================================
@@ -488,6 +687,61 @@ protected:
 		}
 	};
 
+	/**
+	 * Metadata of one shard file, gathered once per dataset so queries can prune shards
+	 * by time range without decoding their payload
+	 */
+	struct FShardInfo
+	{
+		/** Full path of the shard file */
+		FString FilePath;
+
+		/** First time step stored in the shard (parsed from the file name) */
+		int32 StartTimeStep = 0;
+
+		/** Number of time steps stored in the shard */
+		int32 TimeStepIntervalSize = 0;
+
+		/** Number of trajectory entries in the shard */
+		int32 NumTrajectories = 0;
+
+		/** @return Last time step stored in the shard (inclusive) */
+		int32 GetEndTimeStep() const { return StartTimeStep + TimeStepIntervalSize - 1; }
+
+		/** @return True if the shard holds any time step of [InStartTimeStep, InEndTimeStep] */
+		bool OverlapsTimeRange(int32 InStartTimeStep, int32 InEndTimeStep) const
+		{
+			return GetEndTimeStep() >= InStartTimeStep && StartTimeStep <= InEndTimeStep;
+		}
+	};
+
+	/**
+	 * Catalog of all shard files of a dataset directory
+	 */
+	struct FShardCatalog
+	{
+		/** All shard files found in the directory (sorted, including unreadable ones) */
+		TArray<FString> ShardFiles;
+
+		/** Metadata of every readable shard, in ShardFiles order */
+		TArray<FShardInfo> Shards;
+
+		/** Modification time of the dataset directory when ShardFiles was enumerated (MinValue = unknown) */
+		FDateTime DirectoryTimeStamp = FDateTime::MinValue();
+	};
+
+	/**
+	 * Cached per-trajectory shard index together with the catalog it was last validated against
+	 */
+	struct FCachedTrajectoryShardIndex
+	{
+		/** The index */
+		TSharedPtr<const FTrajectoryShardIndex, ESPMode::ThreadSafe> Index;
+
+		/** Catalog whose shard files the index was checked against (no re-check while it is current) */
+		TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe> ValidatedCatalog;
+	};
+
 	/** Map of loaded hash tables */
 	TMap<FHashTableKey, TSharedPtr<FSpatialHashTable>> LoadedHashTables;
 
@@ -497,6 +751,33 @@ protected:
 	/** Critical section for protecting creation flag */
 	FCriticalSection CreationMutex;
 
+	/** Whether newly loaded hash tables are memory-mapped */
+	bool bUseMemoryMappedTables;
+
+	/** Whether newly loaded hash tables build a search index */
+	bool bUseTableSearchIndex;
+
+	/** Whether loaded hash tables use a hash index for cell lookups */
+	bool bUseTableHashIndex;
+
+	/** Maximum prediction error of the learned index of built hash tables (0 = none) */
+	uint32 LearnedIndexMaxError;
+
+	/** Read coalescing gap applied to loaded hash tables (in trajectory IDs) */
+	uint32 ReadCoalesceGap;
+
+	/** Shard catalogs keyed by dataset directory (see GetShardCatalog) */
+	mutable TMap<FString, TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe>> ShardCatalogs;
+
+	/** Protects ShardCatalogs */
+	mutable FCriticalSection ShardCatalogMutex;
+
+	/** Per-trajectory shard indices keyed by dataset directory (see GetTrajectoryShardIndex) */
+	mutable TMap<FString, FCachedTrajectoryShardIndex> TrajectoryShardIndices;
+
+	/** Protects TrajectoryShardIndices */
+	mutable FCriticalSection TrajectoryShardIndexMutex;
+
 	/**
 	 * Get a loaded hash table for a specific cell size and time step
 	 * 
@@ -508,6 +789,8 @@ protected:
 
 	/**
 	 * Check if hash tables exist on disk for the given range
+	 * With a manifest, the range must be recorded and no table file may have been added or
+	 * deleted since the manifest was written (one directory stat, files are checked when loaded).
 	 * 
 	 * @param DatasetDirectory Base directory containing the dataset
 	 * @param CellSize Cell size to check for
@@ -524,50 +807,92 @@ protected:
 	 * @param CellSize Cell size for the hash tables
 	 * @param StartTimeStep First time step to create
 	 * @param EndTimeStep Last time step to create
+	 * @param bForceRebuild Rebuild from all shards even if up-to-date tables exist
 	 * @return True if hash tables were created successfully
 	 */
-	bool TryCreateHashTables(const FString& DatasetDirectory, float CellSize, int32 StartTimeStep, int32 EndTimeStep);
+	bool TryCreateHashTables(const FString& DatasetDirectory, float CellSize, int32 StartTimeStep, int32 EndTimeStep, bool bForceRebuild = false);
+
+	/**
+	 * Attempt to create hash tables for several cell sizes with one pass over the shards
+	 * Cell sizes whose manifest records the shards they were built from are updated
+	 * incrementally: only new shards and shards whose size or modification time changed
+	 * are read (see AppendHashTablesForNewShards).
+	 * 
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param CellSizes Cell sizes for the hash tables (one spatial_hashing/cellsize_X directory each)
+	 * @param StartTimeStep First time step to create
+	 * @param EndTimeStep Last time step to create
+	 * @param bForceRebuild Rebuild all cell sizes from all shards even if up-to-date tables exist
+	 * @return True if hash tables were created successfully for all cell sizes
+	 */
+	bool TryCreateHashTables(const FString& DatasetDirectory, const TArray<float>& CellSizes, int32 StartTimeStep, int32 EndTimeStep, bool bForceRebuild = false);
 
 	/**
-	 * Load trajectory data from dataset directory
-	 * This method uses LoadShardFile to load complete shard data and processes ALL trajectories
-	 * in the dataset, regardless of the time range parameters (which are kept for API compatibility).
+	 * Unload the tables of cell sizes whose files are about to be rewritten
+	 * Memory-mapped tables and pooled handles keep their files open, and some platforms
+	 * (Windows) refuse to overwrite a file that is open for reading. Must be called on
+	 * the game thread, before the build starts.
 	 * 
-	 * The method finds all shard files in the dataset directory, loads them using LoadShardFile,
-	 * and processes them in parallel while managing memory constraints.
+	 * @param CellSizes Cell sizes that will be rebuilt
+	 */
+	void ReleaseHashTablesForRebuild(const TArray<float>& CellSizes);
+
+	/**
+	 * Load the manifest of a cell size, recreating it from the table files if it is missing or outdated
 	 * 
-	 * @param DatasetDirectory Base directory containing trajectory data (with shard-*.bin files)
-	 * @param StartTimeStep Unused - kept for API compatibility (all time steps are processed)
-	 * @param EndTimeStep Unused - kept for API compatibility (all time steps are processed)
-	 * @param OutTimeStepSamples Output array of trajectory samples for each time step in the complete dataset
-	 * @param OutGlobalMinTimeStep Output parameter receiving the first timestep number in the dataset
-	 * @return True if trajectory data was loaded successfully
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param CellSize Cell size of the hash tables
+	 * @param OutManifest Output manifest
+	 * @return True if the cell size has hash tables and a saved manifest
 	 */
-	bool LoadTrajectoryDataFromDirectory(
-		const FString& DatasetDirectory,
-		int32 StartTimeStep,
-		int32 EndTimeStep,
-		TArray<TArray<FSpatialHashTableBuilder::FTrajectorySample>>& OutTimeStepSamples,
-		int32& OutGlobalMinTimeStep);
+	bool LoadOrCreateManifest(const FString& DatasetDirectory, float CellSize, FSpatialHashManifest& OutManifest) const;
 
 	/**
-	 * Build hash tables from shards with batch processing and per-timestep building
-	 * This method processes shards in batches. Each batch:
-	 * - Loads shard files (each shard contains multiple timesteps)
-	 * - Builds one hash table per timestep in parallel
-	 * - Writes hash tables to disk
-	 * - Frees all batch data before loading next batch
+	 * Build hash tables only for new and changed shards (incremental build)
+	 * A shard is rebuilt if a manifest has no record of it or its size or modification time
+	 * differs from the record. Tables of changed and deleted shards are removed first.
+	 * The new tables' bounding boxes start at PersistedBounds and grow to contain their samples.
 	 * 
-	 * No data accumulation across batches - each timestep's hash table is complete
-	 * and independent after building from its batch.
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @param CellSizes Cell sizes to build, all with manifests that record their shards
+	 * @param PersistedBounds Union of the existing tables' bounding boxes
+	 * @return True if all new and changed shards were built (or there were none)
+	 */
+	bool AppendHashTablesForNewShards(const FString& DatasetDirectory, const TArray<float>& CellSizes, const FBox& PersistedBounds);
+
+	/**
+	 * Build hash tables from shards with a streaming pipeline and per-timestep building
+	 * The stages run concurrently on different shards:
+	 * - A reader thread loads shard files ahead (each shard contains multiple timesteps)
+	 * - Samples of a loaded shard are bucketed by timestep in parallel
+	 * - One hash table per timestep and cell size (BaseConfig.GetCellSizes()) is built in parallel
+	 * - A thread pool task saves the tables while the next shard is processed (one write in flight)
+	 * 
+	 * Read-ahead stops while loaded shards, samples and unwritten tables exceed
+	 * BaseConfig.MemoryBudgetBytes. Shards with few time steps are grouped with other
+	 * already loaded shards until there are enough tables to keep all workers busy.
+	 * The peak resident bytes are logged at the end of the build. Each timestep's
+	 * hash table is complete and independent after building from its shard.
+	 * 
+	 * Every shard is read exactly once: start time steps come from the file names and
+	 * interval sizes from the shard headers as they are streamed. If BaseConfig does not
+	 * provide a bounding box, each table gets the running bound of all samples streamed
+	 * so far (plus margin), which its header records for queries. Tables of one set can
+	 * therefore have different bounding boxes (grids); only each table's header describes it.
 	 * 
 	 * @param DatasetDirectory Base directory containing trajectory data
 	 * @param BaseConfig Base configuration for hash table building
+	 * @param ShardFilesToBuild Shard files to build (all shards of the dataset if null); the shard
+	 *                          catalog and index are only updated when all shards are built
+	 * @param InitialBounds Box the running bound starts from (nothing if null); only used when
+	 *                      BaseConfig.bComputeBoundingBox is set
 	 * @return True if hash tables were built successfully
 	 */
 	bool BuildHashTablesIncrementallyFromShards(
 		const FString& DatasetDirectory,
-		const FSpatialHashTableBuilder::FBuildConfig& BaseConfig);
+		const FSpatialHashTableBuilder::FBuildConfig& BaseConfig,
+		const TArray<FString>* ShardFilesToBuild = nullptr,
+		const FBox* InitialBounds = nullptr);
 
 	/**
 	 * Find trajectory positions for distance calculations
@@ -582,6 +907,8 @@ protected:
 	/**
 	 * Load trajectory sample data for specific trajectory IDs and time range
 	 * Loads data from shard files using synchronous LoadShardFile calls.
+	 * With a per-trajectory shard index only shards that overlap the time range and contain
+	 * a requested trajectory are loaded; without one every shard is scanned.
 	 * This method is called from synchronous query methods and uses direct shard loading
 	 * to avoid blocking the game thread with busy-waiting on async callbacks.
 	 * 
@@ -599,6 +926,32 @@ protected:
 		int32 EndTimeStep,
 		TMap<uint32, TArray<FTrajectorySamplePoint>>& OutTrajectoryData) const;
 
+	/**
+	 * Get the shard catalog of a dataset directory
+	 * The catalog is built on first use (one header pass over the shards). While the modification
+	 * time of the directory is unchanged the cached catalog is returned without enumerating the
+	 * directory; otherwise the shard files are listed again and the metadata is only re-read if
+	 * the list changed. Shards rewritten in place (same name) are not detected.
+	 * 
+	 * @param DatasetDirectory Base directory containing trajectory data
+	 * @return Catalog, or nullptr if the directory holds no shard files
+	 */
+	TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe> GetShardCatalog(const FString& DatasetDirectory) const;
+
+	/**
+	 * Get the per-trajectory shard index of a dataset
+	 * Uses the cached index if it still matches the shard files, otherwise loads it from
+	 * spatial_hashing/trajectory_shard_index.bin or builds (and saves) it with one pass over the shards.
+	 * The shard files are only checked when the catalog changed since the last check.
+	 * 
+	 * @param DatasetDirectory Base directory containing trajectory data
+	 * @param Catalog Current shard catalog of the dataset (from GetShardCatalog)
+	 * @return Index, or nullptr if it could not be built
+	 */
+	TSharedPtr<const FTrajectoryShardIndex, ESPMode::ThreadSafe> GetTrajectoryShardIndex(
+		const FString& DatasetDirectory,
+		const TSharedPtr<const FShardCatalog, ESPMode::ThreadSafe>& Catalog) const;
+
 	/**
 	 * Find which shard file contains a specific time step
 	 * 
@@ -674,6 +1027,15 @@ protected:
 	 */
 	bool GetShardFiles(const FString& DatasetDirectory, TArray<FString>& OutShardFiles) const;
 
+	/**
+	 * Get the modification time of a dataset directory for shard catalog invalidation
+	 * Time stamps too recent to tell apart from a concurrent change are reported as unknown.
+	 * 
+	 * @param DatasetDirectory Base directory containing trajectory data
+	 * @return Modification time, or FDateTime::MinValue() if unknown
+	 */
+	static FDateTime GetDirectoryTimeStamp(const FString& DatasetDirectory);
+
 	/**
 	 * Get or load a hash table, returning a raw pointer for use in async callbacks.
 	 * This is a convenience wrapper around GetHashTable() that returns a raw pointer
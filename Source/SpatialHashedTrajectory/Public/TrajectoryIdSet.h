@@ -0,0 +1,149 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Set of trajectory IDs optimized for merging candidates of many queries
+ *
+ * Trajectory IDs are dense integers starting at 0, so the set is stored as a bitset
+ * with one bit per ID. Union and intersection work on 64 IDs per operation, and a
+ * population index (one bit per non-empty word) lets iteration, Reset and the set
+ * operations skip empty regions of the ID space.
+ *
+ * Adding an ID at or above MaxDenseId switches the set to a sparse TSet-based
+ * representation, so a few huge IDs cannot blow up memory usage.
+ *
+ * The interface mirrors the parts of TSet<uint32> used for candidate sets
+ * (Add, Append, Remove, Contains, Num, Array).
+ */
+class SPATIALHASHEDTRAJECTORY_API FTrajectoryIdSet
+{
+public:
+	/** Default largest ID (exclusive) kept in the dense representation: 16M IDs = 2 MB of bits */
+	static constexpr uint32 DefaultMaxDenseId = 1u << 24;
+
+	/**
+	 * @param InMaxDenseId IDs below this bound are stored in the bitset, larger ones switch to sparse mode
+	 *                     (MAX_uint32 keeps every ID but MAX_uint32 itself dense)
+	 */
+	explicit FTrajectoryIdSet(uint32 InMaxDenseId = DefaultMaxDenseId);
+
+	/** Remove all IDs but keep the allocated memory for reuse (returns to dense mode) */
+	void Reset();
+
+	/**
+	 * Add an ID to the set
+	 * @param Id Trajectory ID
+	 * @return true if the ID was not in the set before
+	 */
+	bool Add(uint32 Id);
+
+	/**
+	 * Add several IDs to the set
+	 * @param Ids Trajectory IDs (duplicates allowed)
+	 */
+	void Append(TArrayView<const uint32> Ids);
+
+	/**
+	 * Remove an ID from the set
+	 * @param Id Trajectory ID
+	 * @return true if the ID was in the set
+	 */
+	bool Remove(uint32 Id);
+
+	/**
+	 * Check whether an ID is in the set
+	 * @param Id Trajectory ID
+	 * @return true if the ID is in the set
+	 */
+	bool Contains(uint32 Id) const;
+
+	/** @return Number of IDs in the set */
+	int32 Num() const { return bDense ? DenseCount : SparseIds.Num(); }
+
+	/** @return true if the set uses the bitset representation */
+	bool IsDense() const { return bDense; }
+
+	/**
+	 * Add all IDs of another set (this = this | Other)
+	 * @param Other Set to merge in
+	 */
+	void Union(const FTrajectoryIdSet& Other);
+
+	/**
+	 * Keep only IDs that are also in another set (this = this & Other)
+	 * @param Other Set to intersect with
+	 */
+	void Intersect(const FTrajectoryIdSet& Other);
+
+	/**
+	 * Copy all IDs into an array
+	 * @param OutIds Output array of IDs, sorted ascending
+	 */
+	void ToArray(TArray<uint32>& OutIds) const;
+
+	/** @return All IDs, sorted ascending */
+	TArray<uint32> Array() const;
+
+	/**
+	 * Call a function for every ID in the set
+	 * Dense sets are visited in ascending order, sparse sets in unspecified order.
+	 * @param Func Callable taking a uint32 ID
+	 */
+	template <typename FuncType>
+	void ForEach(FuncType&& Func) const
+	{
+		if (!bDense)
+		{
+			for (uint32 Id : SparseIds)
+			{
+				Func(Id);
+			}
+			return;
+		}
+
+		for (int32 SummaryIndex = 0; SummaryIndex < Summary.Num(); ++SummaryIndex)
+		{
+			uint64 SummaryBits = Summary[SummaryIndex];
+			while (SummaryBits != 0)
+			{
+				const int32 WordIndex = SummaryIndex * 64 + (int32)FMath::CountTrailingZeros64(SummaryBits);
+				SummaryBits &= SummaryBits - 1;
+
+				uint64 WordBits = Words[WordIndex];
+				while (WordBits != 0)
+				{
+					Func((uint32)WordIndex * 64 + (uint32)FMath::CountTrailingZeros64(WordBits));
+					WordBits &= WordBits - 1;
+				}
+			}
+		}
+	}
+
+private:
+	/** Make sure the bitset can hold the word at WordIndex */
+	void EnsureDenseCapacity(int32 WordIndex);
+
+	/** Move all IDs into SparseIds and leave dense mode */
+	void ConvertToSparse();
+
+	/** One bit per ID (dense mode) */
+	TArray<uint64> Words;
+
+	/** Population index: one bit per entry of Words that is non-zero (dense mode) */
+	TArray<uint64> Summary;
+
+	/** Number of set bits in Words */
+	int32 DenseCount;
+
+	/** IDs in sparse mode */
+	TSet<uint32> SparseIds;
+
+	/** IDs at or above this bound switch the set to sparse mode */
+	uint32 MaxDenseId;
+
+	/** Whether the bitset representation is active */
+	bool bDense;
+};
@@ -0,0 +1,152 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FShardFileData;
+
+/**
+ * Sidecar index mapping trajectory IDs to their entries in the dataset's shard files
+ *
+ * Without the index, loading samples for a handful of trajectories decodes every shard
+ * and scans all of its entries. The index records, per trajectory, which shards hold
+ * valid samples for it and at which entry index, so a query only loads the shards that
+ * overlap its time range AND contain a requested trajectory, and then jumps straight
+ * to the requested entries.
+ *
+ * The index is built once with a single pass over the shards and stored as
+ * <DatasetDirectory>/spatial_hashing/trajectory_shard_index.bin. It is rebuilt when the
+ * set of shard files (names or sizes) changes.
+ *
+ * Note: shard payloads are decoded by the TrajectoryData plugin, so the index addresses
+ * entries (not byte offsets) inside a shard.
+ */
+class SPATIALHASHEDTRAJECTORY_API FTrajectoryShardIndex
+{
+public:
+	/** Magic number for file identification: 0x58495354 ("TSIX") */
+	static constexpr uint32 Magic = 0x58495354;
+
+	/** Current file format version */
+	static constexpr uint32 Version = 1;
+
+	/**
+	 * One shard file of the dataset
+	 */
+	struct FShard
+	{
+		/** Shard file name without directory (e.g. "shard-0100.bin") */
+		FString FileName;
+
+		/** File size in bytes when the index was built, used to detect modified shards */
+		int64 FileSize = 0;
+
+		/** First time step stored in the shard */
+		int32 StartTimeStep = 0;
+
+		/** Number of time steps stored in the shard */
+		int32 TimeStepIntervalSize = 0;
+
+		/** @return Last time step stored in the shard (inclusive) */
+		int32 GetEndTimeStep() const { return StartTimeStep + TimeStepIntervalSize - 1; }
+
+		friend FArchive& operator<<(FArchive& Ar, FShard& Shard)
+		{
+			Ar << Shard.FileName << Shard.FileSize << Shard.StartTimeStep << Shard.TimeStepIntervalSize;
+			return Ar;
+		}
+	};
+
+	/**
+	 * Location of one trajectory's samples inside one shard
+	 */
+	struct FLocation
+	{
+		/** Trajectory ID */
+		uint32 TrajectoryId = 0;
+
+		/** Index into Shards */
+		uint32 ShardIndex = 0;
+
+		/** Index of the trajectory's entry in FShardFileData::Entries */
+		uint32 EntryIndex = 0;
+
+		/** Number of valid (non-NaN) samples of the trajectory in this shard */
+		uint32 ValidSampleCount = 0;
+
+		friend FArchive& operator<<(FArchive& Ar, FLocation& Location)
+		{
+			Ar << Location.TrajectoryId << Location.ShardIndex << Location.EntryIndex << Location.ValidSampleCount;
+			return Ar;
+		}
+	};
+
+	/**
+	 * Get the path of the index file for a dataset
+	 * @param DatasetDirectory Base directory containing the dataset
+	 * @return Path to the index file inside the spatial_hashing directory
+	 */
+	static FString GetIndexFilename(const FString& DatasetDirectory);
+
+	/** Remove all shards and locations */
+	void Reset();
+
+	/**
+	 * Add the entries of a loaded shard to the index
+	 * Locations are only searchable after Finalize() has been called.
+	 * @param ShardFile Full path of the shard file
+	 * @param StartTimeStep First time step stored in the shard
+	 * @param ShardData Decoded shard
+	 */
+	void AddShard(const FString& ShardFile, int32 StartTimeStep, const FShardFileData& ShardData);
+
+	/** Sort locations by trajectory ID so they can be looked up */
+	void Finalize();
+
+	/**
+	 * Build the index by loading every shard once
+	 * @param ShardFiles Full paths of all shard files of the dataset (sorted)
+	 * @param ShardStartTimeSteps First time step of each shard (parallel to ShardFiles)
+	 * @return true if at least one shard was indexed
+	 */
+	bool Build(const TArray<FString>& ShardFiles, const TArray<int32>& ShardStartTimeSteps);
+
+	/**
+	 * Check whether the index was built from exactly these shard files
+	 * @param ShardFiles Full paths of all shard files of the dataset (sorted)
+	 * @return true if names and file sizes match
+	 */
+	bool IsUpToDate(const TArray<FString>& ShardFiles) const;
+
+	/**
+	 * Get all shard locations of a trajectory
+	 * @param TrajectoryId Trajectory ID
+	 * @return Locations of the trajectory ordered by shard, empty if the trajectory is unknown
+	 */
+	TArrayView<const FLocation> FindLocations(uint32 TrajectoryId) const;
+
+	/** @return All indexed shards, in the order of the shard file list */
+	const TArray<FShard>& GetShards() const { return Shards; }
+
+	/**
+	 * Save the index to a binary file
+	 * @param Filename Path to output file
+	 * @return true if successful, false otherwise
+	 */
+	bool SaveToFile(const FString& Filename) const;
+
+	/**
+	 * Load the index from a binary file
+	 * @param Filename Path to input file
+	 * @return true if successful, false otherwise
+	 */
+	bool LoadFromFile(const FString& Filename);
+
+private:
+	/** Indexed shards */
+	TArray<FShard> Shards;
+
+	/** Locations sorted by trajectory ID, then shard index */
+	TArray<FLocation> Locations;
+};
@@ -1,5 +1,6 @@
 // Verification tool to check if binary format matches specification-spatial-hash-table.md
 // This can be compiled as a standalone tool or integrated into test suite
+// Understands format versions 1 (raw IDs), 2 (compressed IDs) and 3 (compact entries)
 
 #include <cstdint>
 #include <cstdio>
@@ -9,7 +10,7 @@
 // Expected format from specification-spatial-hash-table.md
 struct SpecHeader {
     uint32_t Magic;          // Offset 0,  Size 4  - 0x54534854
-    uint32_t Version;        // Offset 4,  Size 4  - 1
+    uint32_t Version;        // Offset 4,  Size 4  - 1, 2 or 3
     uint32_t TimeStep;       // Offset 8,  Size 4
     float    CellSize;       // Offset 12, Size 4
     float    BBoxMinX;       // Offset 16, Size 4
@@ -20,39 +21,113 @@ struct SpecHeader {
     float    BBoxMaxZ;       // Offset 36, Size 4
     uint32_t NumEntries;     // Offset 40, Size 4
     uint32_t NumTrajectoryIds; // Offset 44, Size 4
-    uint32_t Reserved[4];    // Offset 48, Size 16
+    uint32_t CompressedIdBytes; // Offset 48, Size 4 - version 2 and later
+    uint32_t EntryGroupSize; // Offset 52, Size 4 - version 3
+    uint32_t LearnedIndexBytes; // Offset 56, Size 4 - version 3
+    uint32_t Reserved;       // Offset 60, Size 4
 };
 
+// Entry record of version 1 and 2 files
 struct SpecEntry {
     uint64_t ZOrderKey;      // Offset 0,  Size 8
-    uint32_t StartIndex;     // Offset 8,  Size 4
+    uint32_t StartIndex;     // Offset 8,  Size 4 - ID index (v1) or block byte offset (v2)
     uint32_t TrajectoryCount; // Offset 12, Size 4
 };
 
+// Segment of the version 3 learned index trailer
+struct SpecLearnedSegment {
+    uint64_t FirstKey;       // Offset 0,  Size 8
+    float    Slope;          // Offset 8,  Size 4
+    uint32_t FirstIndex;     // Offset 12, Size 4
+};
+
 static_assert(sizeof(SpecHeader) == 64, "Header must be 64 bytes");
 static_assert(sizeof(SpecEntry) == 16, "Entry must be 16 bytes");
+static_assert(sizeof(SpecLearnedSegment) == 16, "Learned segment must be 16 bytes");
+
+// Decode one StreamVByte block of Count delta-encoded IDs starting at Block.
+// Returns the block size in bytes, or -1 if it runs past End.
+static long decodeBlock(const uint8_t* Block, const uint8_t* End, uint32_t Count, std::vector<uint32_t>& OutIds) {
+    const uint8_t* Control = Block;
+    const uint8_t* Data = Block + (Count + 3) / 4;
+    if (Data > End) {
+        return -1;
+    }
+
+    uint32_t Previous = 0;
+    for (uint32_t i = 0; i < Count; i++) {
+        uint32_t Length = ((Control[i / 4] >> (2 * (i % 4))) & 3) + 1;
+        if (Data + Length > End) {
+            return -1;
+        }
+        uint32_t Delta = 0;
+        for (uint32_t Byte = 0; Byte < Length; Byte++) {
+            Delta |= (uint32_t)Data[Byte] << (8 * Byte);
+        }
+        Data += Length;
+        Previous += Delta;
+        OutIds.push_back(Previous);
+    }
+    return (long)(Data - Block);
+}
 
-void verifyBinaryFormat(const char* filename) {
+// Check that Keys are strictly ascending
+static bool verifySorted(const std::vector<uint64_t>& Keys) {
+    for (size_t i = 1; i < Keys.size(); i++) {
+        if (Keys[i] <= Keys[i-1]) {
+            printf("\n❌ FAIL: Entries not strictly sorted at index %zu!\n", i);
+            printf("   Entry[%zu].ZOrderKey = 0x%016llX\n", i-1, (unsigned long long)Keys[i-1]);
+            printf("   Entry[%zu].ZOrderKey = 0x%016llX\n", i, (unsigned long long)Keys[i]);
+            return false;
+        }
+    }
+    printf("\n✓ Entries are strictly sorted (ascending, no duplicates)\n");
+    return true;
+}
+
+// Print the first few trajectory IDs
+static void printIds(const std::vector<uint32_t>& Ids) {
+    size_t showCount = Ids.size() < 10 ? Ids.size() : 10;
+    printf("  First %zu IDs: [", showCount);
+    for (size_t i = 0; i < showCount; i++) {
+        printf("%u", Ids[i]);
+        if (i + 1 < showCount) printf(", ");
+    }
+    printf("]\n");
+    if (Ids.size() > 10) {
+        printf("  ... (%zu more IDs)\n", Ids.size() - 10);
+    }
+}
+
+bool verifyBinaryFormat(const char* filename) {
     FILE* file = fopen(filename, "rb");
     if (!file) {
         printf("ERROR: Cannot open file %s\n", filename);
-        return;
+        return false;
     }
 
-    // Read and verify header
-    SpecHeader header;
-    if (fread(&header, sizeof(SpecHeader), 1, file) != 1) {
+    // Read the whole file; every section is checked against its expected offset
+    fseek(file, 0, SEEK_END);
+    long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    std::vector<uint8_t> bytes(fileSize > 0 ? (size_t)fileSize : 0);
+    bool readOk = bytes.empty() || fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    fclose(file);
+
+    if (!readOk || bytes.size() < sizeof(SpecHeader)) {
         printf("ERROR: Failed to read header\n");
-        fclose(file);
-        return;
+        return false;
     }
 
+    SpecHeader header;
+    memcpy(&header, bytes.data(), sizeof(SpecHeader));
+
     printf("=== Binary Format Verification ===\n");
     printf("File: %s\n\n", filename);
 
     printf("HEADER (64 bytes):\n");
     printf("  Offset 0:  Magic = 0x%08X (expected 0x54534854 = 'TSHT')\n", header.Magic);
-    printf("  Offset 4:  Version = %u (expected 1)\n", header.Version);
+    printf("  Offset 4:  Version = %u (expected 1, 2 or 3)\n", header.Version);
     printf("  Offset 8:  TimeStep = %u\n", header.TimeStep);
     printf("  Offset 12: CellSize = %.3f\n", header.CellSize);
     printf("  Offset 16: BBoxMinX = %.3f\n", header.BBoxMinX);
@@ -63,119 +138,218 @@ void verifyBinaryFormat(const char* filename) {
     printf("  Offset 36: BBoxMaxZ = %.3f\n", header.BBoxMaxZ);
     printf("  Offset 40: NumEntries = %u\n", header.NumEntries);
     printf("  Offset 44: NumTrajectoryIds = %u\n", header.NumTrajectoryIds);
-    printf("  Offset 48-63: Reserved (16 bytes)\n");
+    printf("  Offset 48: CompressedIdBytes = %u\n", header.CompressedIdBytes);
+    printf("  Offset 52: EntryGroupSize = %u\n", header.EntryGroupSize);
+    printf("  Offset 56: LearnedIndexBytes = %u\n", header.LearnedIndexBytes);
+    printf("  Offset 60: Reserved (4 bytes)\n");
+
+    bool pass = true;
 
     // Verify magic number
     if (header.Magic != 0x54534854) {
         printf("\n❌ FAIL: Invalid magic number!\n");
+        pass = false;
     } else {
         printf("\n✓ Magic number correct\n");
     }
 
     // Verify version
-    if (header.Version != 1) {
+    if (header.Version < 1 || header.Version > 3) {
         printf("❌ FAIL: Invalid version!\n");
+        printf("\n=== VERIFICATION RESULT ===\n");
+        printf("❌ FAIL: Binary format does NOT match specification\n");
+        return false;
+    }
+    printf("✓ Version %u supported\n", header.Version);
+
+    if (header.Version == 3 && header.EntryGroupSize == 0) {
+        printf("❌ FAIL: Entry group size must not be 0\n");
+        printf("\n=== VERIFICATION RESULT ===\n");
+        printf("❌ FAIL: Binary format does NOT match specification\n");
+        return false;
+    }
+
+    // Section sizes implied by the header
+    const uint64_t numGroups = header.Version == 3
+        ? ((uint64_t)header.NumEntries + header.EntryGroupSize - 1) / header.EntryGroupSize : 0;
+    const uint64_t entryBytes = header.Version == 3
+        ? (uint64_t)header.NumEntries * 12 + (numGroups + 1) * 4
+        : (uint64_t)header.NumEntries * sizeof(SpecEntry);
+    const uint64_t idBytes = header.Version == 1
+        ? (uint64_t)header.NumTrajectoryIds * 4 : header.CompressedIdBytes;
+    const uint64_t learnedBytes = header.Version == 3 ? header.LearnedIndexBytes : 0;
+    const uint64_t idOffset = sizeof(SpecHeader) + entryBytes;
+    const uint64_t expectedSize = idOffset + idBytes + learnedBytes;
+
+    printf("\nFILE SIZE:\n");
+    printf("  Actual: %ld bytes\n", fileSize);
+    printf("  Expected: %llu bytes (64 header + %llu entries + %llu trajectory IDs + %llu learned index)\n",
+           (unsigned long long)expectedSize, (unsigned long long)entryBytes,
+           (unsigned long long)idBytes, (unsigned long long)learnedBytes);
+    if ((uint64_t)fileSize != expectedSize) {
+        printf("❌ FAIL: File size mismatch!\n");
+        printf("\n=== VERIFICATION RESULT ===\n");
+        printf("❌ FAIL: Binary format does NOT match specification\n");
+        return false;
+    }
+    printf("✓ File size matches specification\n");
+
+    // Entries as keys and counts, plus the version 1/2 start indices
+    std::vector<uint64_t> keys(header.NumEntries);
+    std::vector<uint32_t> counts(header.NumEntries);
+    std::vector<uint32_t> starts;
+    std::vector<uint32_t> groupOffsets;
+    const uint8_t* entryData = bytes.data() + sizeof(SpecHeader);
+    if (header.Version == 3) {
+        printf("\nENTRIES (%u entries: 8-byte keys, 4-byte counts, %llu group offsets):\n",
+               header.NumEntries, (unsigned long long)numGroups + 1);
+        memcpy(keys.data(), entryData, keys.size() * sizeof(uint64_t));
+        memcpy(counts.data(), entryData + keys.size() * sizeof(uint64_t), counts.size() * sizeof(uint32_t));
+        groupOffsets.resize((size_t)numGroups + 1);
+        memcpy(groupOffsets.data(), entryData + (size_t)header.NumEntries * 12, groupOffsets.size() * sizeof(uint32_t));
     } else {
-        printf("✓ Version correct\n");
-    }
-
-    // Read and verify entries
-    printf("\nENTRIES (%u entries, 16 bytes each):\n", header.NumEntries);
-    
-    std::vector<SpecEntry> entries(header.NumEntries);
-    if (header.NumEntries > 0) {
-        if (fread(entries.data(), sizeof(SpecEntry), header.NumEntries, file) != header.NumEntries) {
-            printf("ERROR: Failed to read entries\n");
-            fclose(file);
-            return;
+        printf("\nENTRIES (%u entries, 16 bytes each):\n", header.NumEntries);
+        starts.resize(header.NumEntries);
+        for (uint32_t i = 0; i < header.NumEntries; i++) {
+            SpecEntry entry;
+            memcpy(&entry, entryData + (size_t)i * sizeof(SpecEntry), sizeof(SpecEntry));
+            keys[i] = entry.ZOrderKey;
+            starts[i] = entry.StartIndex;
+            counts[i] = entry.TrajectoryCount;
         }
+    }
 
-        // Show first few entries
-        uint32_t showCount = header.NumEntries < 5 ? header.NumEntries : 5;
-        for (uint32_t i = 0; i < showCount; i++) {
-            printf("  Entry[%u]: ZOrderKey=0x%016llX, StartIndex=%u, TrajectoryCount=%u\n",
-                   i, (unsigned long long)entries[i].ZOrderKey, 
-                   entries[i].StartIndex, entries[i].TrajectoryCount);
-        }
-        if (header.NumEntries > 5) {
-            printf("  ... (%u more entries)\n", header.NumEntries - 5);
+    // Show first few entries
+    uint32_t showCount = header.NumEntries < 5 ? header.NumEntries : 5;
+    for (uint32_t i = 0; i < showCount; i++) {
+        printf("  Entry[%u]: ZOrderKey=0x%016llX, TrajectoryCount=%u\n",
+               i, (unsigned long long)keys[i], counts[i]);
+    }
+    if (header.NumEntries > 5) {
+        printf("  ... (%u more entries)\n", header.NumEntries - 5);
+    }
+
+    pass = verifySorted(keys) && pass;
+
+    uint64_t totalCount = 0;
+    for (uint32_t count : counts) {
+        totalCount += count;
+    }
+    if (totalCount != header.NumTrajectoryIds) {
+        printf("❌ FAIL: Entry counts sum to %llu, header says %u\n",
+               (unsigned long long)totalCount, header.NumTrajectoryIds);
+        pass = false;
+    } else {
+        printf("✓ Entry counts add up to NumTrajectoryIds\n");
+    }
+
+    // Trajectory IDs
+    const uint8_t* idData = bytes.data() + idOffset;
+    const uint8_t* idEnd = idData + idBytes;
+    std::vector<uint32_t> trajectoryIds;
+    trajectoryIds.reserve(header.NumTrajectoryIds);
+    if (header.Version == 1) {
+        printf("\nTRAJECTORY IDs (%u IDs, 4 bytes each):\n", header.NumTrajectoryIds);
+        trajectoryIds.resize(header.NumTrajectoryIds);
+        memcpy(trajectoryIds.data(), idData, trajectoryIds.size() * sizeof(uint32_t));
+
+        // Start indices are the prefix sums of the counts
+        uint32_t expectedStart = 0;
+        for (uint32_t i = 0; i < header.NumEntries && pass; i++) {
+            if (starts[i] != expectedStart) {
+                printf("❌ FAIL: Entry[%u].StartIndex = %u, expected %u\n", i, starts[i], expectedStart);
+                pass = false;
+            }
+            expectedStart += counts[i];
         }
+    } else {
+        printf("\nTRAJECTORY IDs (%u IDs in %u compressed bytes):\n", header.NumTrajectoryIds, header.CompressedIdBytes);
+
+        // Walk the blocks in entry order; each must start where the file says it does
+        uint64_t offset = 0;
+        for (uint32_t i = 0; i < header.NumEntries && pass; i++) {
+            bool sampled = header.Version == 2 || i % header.EntryGroupSize == 0;
+            uint32_t recorded = header.Version == 2 ? starts[i] : groupOffsets[i / header.EntryGroupSize];
+            if (sampled && recorded != offset) {
+                printf("❌ FAIL: Block of entry %u recorded at byte %u, found at byte %llu\n",
+                       i, recorded, (unsigned long long)offset);
+                pass = false;
+                break;
+            }
 
-        // Verify entries are sorted in strictly ascending order
-        // Note: The implementation uses TMap which ensures unique keys,
-        // so Z-Order keys must be strictly increasing (no duplicates)
-        bool sorted = true;
-        for (uint32_t i = 1; i < header.NumEntries; i++) {
-            if (entries[i].ZOrderKey <= entries[i-1].ZOrderKey) {
-                printf("\n❌ FAIL: Entries not strictly sorted at index %u!\n", i);
-                printf("   Entry[%u].ZOrderKey = 0x%016llX\n", i-1, 
-                       (unsigned long long)entries[i-1].ZOrderKey);
-                printf("   Entry[%u].ZOrderKey = 0x%016llX\n", i, 
-                       (unsigned long long)entries[i].ZOrderKey);
-                sorted = false;
+            size_t firstId = trajectoryIds.size();
+            long blockSize = decodeBlock(idData + offset, idEnd, counts[i], trajectoryIds);
+            if (blockSize < 0) {
+                printf("❌ FAIL: Block of entry %u is truncated\n", i);
+                pass = false;
                 break;
             }
+            for (size_t id = firstId + 1; id < trajectoryIds.size(); id++) {
+                if (trajectoryIds[id] < trajectoryIds[id - 1]) {
+                    printf("❌ FAIL: Trajectory IDs of entry %u are not sorted\n", i);
+                    pass = false;
+                    break;
+                }
+            }
+            offset += (uint64_t)blockSize;
         }
-        if (sorted) {
-            printf("\n✓ Entries are strictly sorted (ascending, no duplicates)\n");
+
+        uint32_t recordedEnd = header.Version == 2 ? header.CompressedIdBytes : groupOffsets.back();
+        if (pass && (offset != header.CompressedIdBytes || recordedEnd != header.CompressedIdBytes)) {
+            printf("❌ FAIL: Blocks end at byte %llu, section size is %u\n",
+                   (unsigned long long)offset, header.CompressedIdBytes);
+            pass = false;
+        } else if (pass) {
+            printf("✓ Compressed blocks decode to %zu IDs and fill the section\n", trajectoryIds.size());
         }
     }
+    if (!trajectoryIds.empty()) {
+        printIds(trajectoryIds);
+    }
 
-    // Read and verify trajectory IDs
-    printf("\nTRAJECTORY IDs (%u IDs, 4 bytes each):\n", header.NumTrajectoryIds);
-    
-    std::vector<uint32_t> trajectoryIds(header.NumTrajectoryIds);
-    if (header.NumTrajectoryIds > 0) {
-        if (fread(trajectoryIds.data(), sizeof(uint32_t), header.NumTrajectoryIds, file) != header.NumTrajectoryIds) {
-            printf("ERROR: Failed to read trajectory IDs\n");
-            fclose(file);
-            return;
+    // Learned index trailer
+    if (learnedBytes > 0) {
+        printf("\nLEARNED INDEX (%llu bytes):\n", (unsigned long long)learnedBytes);
+        const uint8_t* trailer = idEnd;
+        uint32_t maxError = 0;
+        uint32_t numSegments = 0;
+        if (learnedBytes >= 8) {
+            memcpy(&maxError, trailer, 4);
+            memcpy(&numSegments, trailer + 4, 4);
         }
+        printf("  MaxError = %u, Segments = %u\n", maxError, numSegments);
 
-        // Show first few IDs
-        uint32_t showCount = header.NumTrajectoryIds < 10 ? header.NumTrajectoryIds : 10;
-        printf("  First %u IDs: [", showCount);
-        for (uint32_t i = 0; i < showCount; i++) {
-            printf("%u", trajectoryIds[i]);
-            if (i < showCount - 1) printf(", ");
-        }
-        printf("]\n");
-        if (header.NumTrajectoryIds > 10) {
-            printf("  ... (%u more IDs)\n", header.NumTrajectoryIds - 10);
+        if (learnedBytes < 8 || numSegments == 0 || learnedBytes != 8 + (uint64_t)numSegments * sizeof(SpecLearnedSegment)) {
+            printf("❌ FAIL: Learned index size does not match its segment count\n");
+            pass = false;
+        } else {
+            std::vector<SpecLearnedSegment> segments(numSegments);
+            memcpy(segments.data(), trailer + 8, segments.size() * sizeof(SpecLearnedSegment));
+            // Each segment starts at an entry, after the previous segment's first entry
+            bool segmentsOk = segments[0].FirstIndex == 0;
+            for (uint32_t i = 0; i < numSegments && segmentsOk; i++) {
+                segmentsOk = segments[i].FirstIndex < header.NumEntries
+                          && segments[i].FirstKey == keys[segments[i].FirstIndex]
+                          && (i == 0 || segments[i].FirstIndex > segments[i - 1].FirstIndex);
+            }
+            if (!segmentsOk) {
+                printf("❌ FAIL: Learned segments do not start at ascending entries\n");
+                pass = false;
+            } else {
+                printf("✓ Learned segments start at ascending entries\n");
+            }
         }
     }
 
-    // Check file size
-    long currentPos = ftell(file);
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    
-    long expectedSize = sizeof(SpecHeader) + 
-                       header.NumEntries * sizeof(SpecEntry) + 
-                       header.NumTrajectoryIds * sizeof(uint32_t);
-    
-    printf("\nFILE SIZE:\n");
-    printf("  Actual: %ld bytes\n", fileSize);
-    printf("  Expected: %ld bytes (64 + %u×16 + %u×4)\n", 
-           expectedSize, header.NumEntries, header.NumTrajectoryIds);
-    
-    if (fileSize == expectedSize) {
-        printf("✓ File size matches specification\n");
-    } else {
-        printf("❌ FAIL: File size mismatch!\n");
-    }
-
     // Summary
     printf("\n=== VERIFICATION RESULT ===\n");
-    if (header.Magic == 0x54534854 && 
-        header.Version == 1 && 
-        fileSize == expectedSize) {
-        printf("✅ PASS: Binary format matches specification-spatial-hash-table.md\n");
+    if (pass) {
+        printf("✅ PASS: Binary format (version %u) matches specification-spatial-hash-table.md\n", header.Version);
     } else {
         printf("❌ FAIL: Binary format does NOT match specification\n");
     }
 
-    fclose(file);
+    return pass;
 }
 
 int main(int argc, char* argv[]) {
@@ -185,6 +359,5 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    verifyBinaryFormat(argv[1]);
-    return 0;
+    return verifyBinaryFormat(argv[1]) ? 0 : 1;
 }